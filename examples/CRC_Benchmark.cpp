@@ -0,0 +1,120 @@
+/*
+ * File Name: CRC_Benchmark.cpp
+ * Description: The following code is an example for the LT8722 library. This
+ *              example measures the CPU cycles per frame of the four CRC
+ *              implementations that can be selected with LT8722_CRC (table
+ *              in flash, table in internal RAM, nibble table and bitwise
+ *              calculation). LT8722_CRC only selects the one used by 
+ *              getCRC6(), so all four functions of CRC8.cpp are measured
+ *              and checked against getCRC6(). They are placed like 
+ *              getCRC6(), in IRAM and with the table of LT8722_CRC_TABLE in
+ *              internal RAM only with LT8722_USE_IRAM.
+ *              Every variant is measured warm (tables in the cache) and
+ *              under cache pressure (the data cache is flushed by reading a
+ *              large array in flash before every frame). The result is
+ *              printed as CSV and the default of LT8722_CRC in
+ *              LT8722Config.h should follow the fastest cold variant.
+ *
+ * Revision History:
+ * Date: 2026-10-18 Author: Jan kleine Piening Comments: Initial version created
+ * Date: 2026-10-18 Author: Jan kleine Piening Comments: Functions of CRC8.cpp measured instead of copies
+ *
+ * Author: Jan kleine Piening Start Date: 2026-10-18
+ *
+ * Notes: This code was written as part of my master's thesis at the
+ *        Institute for Microsensors, -actuators and -systems (IMSAS)
+ *        at the University of Bremen.
+ */
+
+#include <Arduino.h>
+#include <LT8722.h>
+#include <CRC8.h>
+#include <esp_cpu.h>
+
+#define FRAMES      2000                                                //frames per variant and cache state
+#define EVICT_BYTES 65536                                               //larger than the data cache of all ESP32 variants
+#define CACHE_LINE  32                                                  //smallest cache line of all ESP32 variants
+
+const uint8_t evictBuffer[EVICT_BYTES] = {1};                           //read before every cold frame to flush the data cache
+
+struct Variant {
+  const char *name;
+  uint8_t (*crc)(uint8_t *data1, uint8_t *data2);
+};
+
+//the implementations of CRC8.cpp, each one is compiled independent of LT8722_CRC
+const Variant variants[] = {
+  {"LT8722_CRC_TABLE", getCRC6Table},
+  {"LT8722_CRC_TABLE_RAM", getCRC6TableRAM},
+  {"LT8722_CRC_NIBBLE", getCRC6Nibble},
+  {"LT8722_CRC_BITWISE", getCRC6Bitwise},
+};
+
+volatile uint32_t sink;                                                 //keeps the reads of the eviction from being removed
+
+void evictCache() {
+  uint32_t sum = 0;
+  for (uint32_t i = 0; i < EVICT_BYTES; i += CACHE_LINE) {
+    sum += ((volatile const uint8_t *)evictBuffer)[i];
+  }
+  sink = sum;
+}
+
+void fillFrame(uint8_t *frame, uint32_t index) {
+  frame[0] = 0xF2;                                                      //write command to the SPIS_DAC register
+  frame[1] = 0x04 << 1;
+  frame[2] = index >> 24;
+  frame[3] = index >> 16;
+  frame[4] = (index * 0x9E37) >> 8;
+  frame[5] = index * 0x9E37;
+}
+
+/**************************************************************************/
+/*!
+    @brief Measure the mean number of cycles of one CRC over six bytes
+    @param variant CRC implementation to be measured
+    @param cold Flush the data cache before every frame
+    @param identical Output, False if any CRC differs from getCRC6()
+    @return Mean number of cycles per frame
+*/
+/**************************************************************************/
+uint32_t measure(const Variant &variant, bool cold, bool &identical) {
+  uint8_t frame[6];
+  uint64_t cycles = 0;
+
+  identical = true;
+  for (uint32_t i = 0; i < FRAMES; i++) {
+    fillFrame(frame, i);
+    if (cold) {
+      evictCache();
+    }
+
+    uint32_t start = esp_cpu_get_cycle_count();
+    uint8_t crc = variant.crc(frame, frame + 2);
+    cycles += esp_cpu_get_cycle_count() - start;
+
+    identical &= (crc == getCRC6(frame, frame + 2));
+  }
+
+  return cycles / FRAMES;
+}
+
+void setup() {
+  Serial.begin(115200);
+  delay(5000);
+
+  Serial.println("variant,warm cycles/frame,cold cycles/frame,identical");
+
+  for (uint8_t i = 0; i < sizeof(variants) / sizeof(variants[0]); i++) {
+    bool identicalWarm;
+    bool identicalCold;
+    uint32_t warm = measure(variants[i], false, identicalWarm);
+    uint32_t cold = measure(variants[i], true, identicalCold);
+
+    Serial.printf("%s,%u,%u,%s\n", variants[i].name, warm, cold, (identicalWarm && identicalCold) ? "yes" : "no");
+  }
+}
+
+void loop() {
+  delay(1000);
+}
@@ -0,0 +1,176 @@
+/*
+ * File Name: Channel_Scaling_Benchmark.cpp
+ * Description: The following code is an example for the LT8722 library. This
+ *              example measures how the update rate degrades with the number
+ *              of channels. For 1 to LT8722_MAX_DEVICES channels (every
+ *              device has to be registered for the emergency shutdown) and
+ *              for every execution mode (sequential and LT8722Executor) a
+ *              realistic mix of setpoint updates, status polls and register
+ *              telemetry is run for one second. The achievable update rate,
+ *              the SPI bus utilization and the p99 latency of the setpoint
+ *              updates are printed as CSV, followed by the capacity of
+ *              every mode: the largest number of channels that still meets
+ *              the update rate of TARGET_RATE_HZ with a p99 latency within
+ *              one period. The CS pins are reused cyclically when there are more
+ *              channels than pins; pins without a device still give the
+ *              correct bus timing (the frames are just not acknowledged),
+ *              they are listed before the results.
+ *
+ * Revision History:
+ * Date: 2026-10-18 Author: Jan kleine Piening Comments: Initial version created
+ * Date: 2026-10-18 Author: Jan kleine Piening Comments: Limited to LT8722_MAX_DEVICES channels, result of begin() checked
+ * Date: 2026-10-18 Author: Jan kleine Piening Comments: Every channel count measured, capacity printed
+ *
+ * Author: Jan kleine Piening Start Date: 2026-10-18
+ *
+ * Notes: This code was written as part of my master's thesis at the
+ *        Institute for Microsensors, -actuators and -systems (IMSAS)
+ *        at the University of Bremen.
+ */
+
+#include <Arduino.h>
+#include <LT8722.h>
+#include <LT8722Executor.h>
+
+#define MAX_CHANNELS      LT8722_MAX_DEVICES                            //largest number of channels to be measured
+#define TARGET_RATE_HZ    1000                                          //update rate per channel the capacity is stated for
+#define STATUS_INTERVAL   10                                            //status poll every 10th cycle
+#define TELEMETRY_INTERVAL 100                                          //register telemetry every 100th cycle
+#define BUCKET_US         10                                            //resolution of the latency histogram
+#define BUCKETS           2000                                          //latencies up to 20ms
+
+const uint8_t csPins[] = {10, 9, 14, 15, 16, 17, 18, 21};               //CS pins of the connected devices
+
+struct Channel {
+  LT8722 *device;
+  LT8722::VoltageCode code;
+  uint32_t cycle;
+};
+
+LT8722 *devices[MAX_CHANNELS];
+Channel channels[MAX_CHANNELS];
+uint32_t histogram[BUCKETS];
+uint32_t cycleStart;
+uint32_t frameBits;
+
+const LT8722::VoltageCode lowCode = LT8722::voltageCode(1.0_V);         //setpoints calculated at compile time
+const LT8722::VoltageCode highCode = LT8722::voltageCode(2.0_V);
+
+void record(uint32_t latency) {
+  uint32_t bucket = latency / BUCKET_US;
+  histogram[(bucket < BUCKETS) ? bucket : BUCKETS - 1]++;
+}
+
+uint32_t percentile99() {
+  uint32_t total = 0;
+  for (uint32_t i = 0; i < BUCKETS; i++) {
+    total += histogram[i];
+  }
+
+  uint32_t sum = 0;
+  for (uint32_t i = 0; i < BUCKETS; i++) {
+    sum += histogram[i];
+    if (sum * 100 >= total * 99) {
+      return (i + 1) * BUCKET_US;
+    }
+  }
+  return BUCKETS * BUCKET_US;
+}
+
+void compute(uint8_t index, void *context) {
+  Channel *channel = (Channel *)context;
+  channel->code = (channel->cycle & 0x01) ? highCode : lowCode;         //stand-in for the control law of the channel
+}
+
+void issue(uint8_t index, void *context) {
+  Channel *channel = (Channel *)context;
+
+  channel->device->setVoltage(channel->code);                           //setpoint update, 64 bit frame
+  record(micros() - cycleStart);
+  frameBits += 64;
+
+  if (channel->cycle % STATUS_INTERVAL == 0) {
+    channel->device->getStatus();                                       //status poll, 32 bit frame
+    frameBits += 32;
+  }
+  if (channel->cycle % TELEMETRY_INTERVAL == 0) {
+    channel->device->getCommand();                                      //register telemetry, 64 bit frame
+    frameBits += 64;
+  }
+  channel->cycle++;
+}
+
+//returns true if the update rate and the p99 latency meet TARGET_RATE_HZ
+bool run(const char *mode, uint8_t count, LT8722Executor *executor) {
+  uint32_t cycles = 0;
+  memset(histogram, 0, sizeof(histogram));
+  frameBits = 0;
+
+  uint32_t start = micros();
+  while (micros() - start < 1000000) {
+    cycleStart = micros();
+    if (executor != NULL) {
+      executor->runCycle();
+    } else {
+      for (uint8_t i = 0; i < count; i++) {
+        compute(i, &channels[i]);
+        issue(i, &channels[i]);
+      }
+    }
+    cycles++;
+  }
+  uint32_t elapsed = micros() - start;
+
+  double updateRate = cycles * 1000000.0 / elapsed;                     //setpoint updates per second and channel
+  double busUtilization = frameBits / 4.0 / elapsed;                    //bits at 4MHz divided by the elapsed time
+
+  uint32_t latency = percentile99();
+
+  Serial.printf("%u,%s,%.1f,%.3f,%u\n", count, mode, updateRate, busUtilization, latency);
+
+  return updateRate >= TARGET_RATE_HZ && latency <= 1000000 / TARGET_RATE_HZ;
+}
+
+void setup() {
+  Serial.begin(115200);
+  delay(5000);
+
+  for (uint8_t i = 0; i < MAX_CHANNELS; i++) {
+    devices[i] = new LT8722();
+    if (devices[i]->begin(13, 11, 12, csPins[i % sizeof(csPins)])) {    //error if the device does not respond or is not registered
+      Serial.printf("Channel %u: begin failed (CS pin %u)\n", i, csPins[i % sizeof(csPins)]);
+    }
+    channels[i].device = devices[i];
+    channels[i].code = lowCode;
+    channels[i].cycle = 0;
+  }
+
+  Serial.println("channels,mode,update_rate_hz,bus_utilization,p99_latency_us");
+
+  uint8_t sequentialCapacity = 0;
+  uint8_t executorCapacity = 0;
+
+  for (uint8_t count = 1; count <= MAX_CHANNELS; count++) {
+    if (run("sequential", count, NULL)) {
+      sequentialCapacity = count;
+    }
+
+    LT8722Executor executor;
+    executor.begin(2, 1000000 / TARGET_RATE_HZ);
+    for (uint8_t i = 0; i < count; i++) {
+      executor.addChannel(compute, issue, &channels[i]);
+    }
+    if (run("executor", count, &executor)) {
+      executorCapacity = count;
+    }
+    executor.end();
+  }
+
+  //largest number of channels that meets the budget, MAX_CHANNELS means the limit was not reached
+  Serial.println("mode,capacity_channels,target_rate_hz");
+  Serial.printf("sequential,%u,%u\n", sequentialCapacity, TARGET_RATE_HZ);
+  Serial.printf("executor,%u,%u\n", executorCapacity, TARGET_RATE_HZ);
+}
+
+void loop() {
+}
@@ -0,0 +1,116 @@
+/*
+ * File Name: Fault_Recovery.cpp
+ * Description: The following code is an example for the LT8722 library. This
+ *              example measures how long the library takes to notice and
+ *              recover from faults. Every scenario (dropped acknowledge,
+ *              corrupted CRC, latched overcurrent and thermal shutdown,
+ *              registers reset to their defaults and stuck analog
+ *              output) is injected while the output is at a fixed setpoint.
+ *              The detection latency, the recovery time, the frames spent,
+ *              the deviation of the output voltage from the setpoint and
+ *              whether the limit registers were restored are printed as
+ *              CSV, followed by PASS or FAIL against the recovery budgets
+ *              below, so a test stand can compare the results between
+ *              library versions.
+ *              Requires build_flags = -DLT8722_FAULT_INJECTION.
+ *
+ * Revision History:
+ * Date: 2026-10-18 Author: Jan kleine Piening Comments: Initial version created
+ * Date: 2026-10-18 Author: Jan kleine Piening Comments: Restored limit registers checked
+ *
+ * Author: Jan kleine Piening Start Date: 2026-10-18
+ *
+ * Notes: This code was written as part of my master's thesis at the
+ *        Institute for Microsensors, -actuators and -systems (IMSAS)
+ *        at the University of Bremen.
+ */
+
+#include <Arduino.h>
+#include <LT8722.h>
+#include <LT8722FaultInjection.h>
+
+#ifndef LT8722_FAULT_INJECTION
+#error "Fault_Recovery.cpp requires build_flags = -DLT8722_FAULT_INJECTION"
+#endif
+
+#define SETPOINT          2.0                                           //output voltage during the scenarios
+#define CHECK_INTERVAL_US 1000                                          //period of the health check
+#define BUDGET_COMM_US    200                                           //recovery budget for communication faults
+#define BUDGET_LATCHED_US 2000                                          //recovery budget for latched faults and register resets
+#define BUDGET_ANALOG_US  5000                                          //recovery budget for a stuck analog output
+
+struct Scenario {
+  const char *name;
+  FAULT fault;
+  uint32_t frames;
+  uint32_t budget;
+};
+
+const Scenario scenarios[] = {
+  {"dropped_ack",      FAULT::NO_ACK,              2, BUDGET_COMM_US},
+  {"corrupted_crc",    FAULT::CRC_ERROR,           2, BUDGET_COMM_US},
+  {"over_current",     FAULT::OVER_CURRENT,        0, BUDGET_LATCHED_US},
+  {"over_temperature", FAULT::OVER_TEMPERATURE,    0, BUDGET_LATCHED_US},
+  {"register_reset",   FAULT::REGISTER_RESET,      0, BUDGET_LATCHED_US},
+  {"stuck_aout",       FAULT::STUCK_ANALOG_OUTPUT, 1, BUDGET_ANALOG_US}
+};
+
+LT8722 peltierDriver;                                                   //create a LT8722 object with FSPI
+
+void setup() {
+  Serial.begin(115200);
+  delay(5000);
+
+  peltierDriver.begin();
+  peltierDriver.softStart();
+  peltierDriver.setPositiveVoltageLimit(VOLTAGE_LIMIT::LIMIT_5_00);     //all limit registers are set, so a register reset has to restore them
+  peltierDriver.setNegativeVoltageLimit(VOLTAGE_LIMIT::LIMIT_5_00);
+  peltierDriver.setPositiveCurrentLimit(4.5);
+  peltierDriver.setNegativeCurrentLimit(4.5);
+  peltierDriver.setVoltage(SETPOINT);
+  delay(100);
+
+  bool passed = true;
+  Serial.println("scenario,detected,detection_us,recovery_us,frames,deviation_v,limits_restored,result");
+
+  for (uint8_t i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++) {
+    const Scenario &scenario = scenarios[i];
+    bool checkAnalogOutput = (scenario.fault == FAULT::STUCK_ANALOG_OUTPUT);
+
+    //the fault occurs at a random point between two health checks
+    uint32_t nextCheck = micros() + random(CHECK_INTERVAL_US);
+    LT8722FaultInjection::inject(10, scenario.fault, scenario.frames);
+    uint32_t injected = micros();
+
+    FAULT detected = FAULT::NONE;
+    while (detected == FAULT::NONE && micros() - injected < 100 * CHECK_INTERVAL_US) {
+      while ((int32_t)(micros() - nextCheck) < 0) {
+      }
+      nextCheck += CHECK_INTERVAL_US;
+      detected = peltierDriver.checkHealth(checkAnalogOutput);
+    }
+    uint32_t detection = micros() - injected;
+
+    LT8722FaultInjection::resetFrames();
+    bool failed = peltierDriver.recover(detected);
+    uint32_t frames = LT8722FaultInjection::getFrames();
+    uint32_t recovery = peltierDriver.getRecoveryTime();
+
+    double deviation = fabs(peltierDriver.readAnalogOutput(ANALOG_OUTPUT::VOLTAGE) - SETPOINT);
+    bool restored = (LT8722FaultInjection::getResetRegisters() == 0);
+
+    bool pass = !failed && detected == scenario.fault && recovery <= scenario.budget && restored;
+    passed &= pass;
+
+    Serial.printf("%s,%u,%u,%u,%u,%.3f,%u,%s\n", scenario.name, static_cast<uint8_t>(detected), detection,
+                  recovery, frames, deviation, restored, pass ? "PASS" : "FAIL");
+
+    LT8722FaultInjection::clear();
+    delay(100);
+  }
+
+  Serial.println(passed ? "PASS" : "FAIL");
+}
+
+void loop() {
+}
@@ -0,0 +1,136 @@
+/*
+ * File Name: Flash_Safe_Setpoints.cpp
+ * Description: The following code is an example for the LT8722 library. This
+ *              example updates the output voltage from a hardware timer
+ *              interrupt every millisecond while the loop keeps writing to
+ *              LittleFS. The interrupt is IRAM-safe, so it keeps firing
+ *              while the flash cache is disabled, and the whole setpoint
+ *              path (setVoltage() with a precalculated register value)
+ *              runs from IRAM. The number of updates, the longest interval
+ *              between two updates and the worst-case duration of an
+ *              update are printed every second. It requires
+ *              build_flags = -DLT8722_USE_IRAM and CONFIG_GPTIMER_ISR_IRAM_SAFE
+ *              (e.g. custom_sdkconfig = CONFIG_GPTIMER_ISR_IRAM_SAFE=y with
+ *              pioarduino).
+ *
+ * Revision History:
+ * Date: 2026-10-18 Author: Jan kleine Piening Comments: Initial version created
+ * Date: 2026-10-18 Author: Jan kleine Piening Comments: Setpoints from an IRAM-safe timer interrupt instead of a task
+ *
+ * Author: Jan kleine Piening Start Date: 2026-10-18
+ *
+ * Notes: This code was written as part of my master's thesis at the
+ *        Institute for Microsensors, -actuators and -systems (IMSAS)
+ *        at the University of Bremen.
+ */
+
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <LT8722.h>
+#include <driver/gptimer.h>
+#include <esp_timer.h>
+
+#ifndef LT8722_USE_IRAM
+#error "Flash_Safe_Setpoints requires build_flags = -DLT8722_USE_IRAM"
+#endif
+
+#if !CONFIG_GPTIMER_ISR_IRAM_SAFE
+#error "Flash_Safe_Setpoints requires CONFIG_GPTIMER_ISR_IRAM_SAFE, otherwise the timer interrupt is disabled during flash writes"
+#endif
+
+#define PERIOD_US 1000                                                  //time between two setpoint updates
+
+LT8722 peltierDriver;                                                   //create a LT8722 object with FSPI
+gptimer_handle_t timer = NULL;
+
+//everything used in the interrupt has to be in internal RAM
+DRAM_ATTR LT8722::VoltageCode setpoints[] = {LT8722::voltageCode(1.0_V), LT8722::voltageCode(2.0_V)};
+DRAM_ATTR volatile uint32_t updates = 0;                                //number of setpoint updates
+DRAM_ATTR volatile uint32_t errors = 0;                                 //number of updates with an SPI error
+DRAM_ATTR volatile uint32_t worstInterval = 0;                          //longest time between two updates in microseconds
+DRAM_ATTR volatile uint32_t worstDuration = 0;                          //longest setpoint update in microseconds
+DRAM_ATTR volatile int64_t lastUpdate = 0;
+
+bool IRAM_ATTR setpointISR(gptimer_handle_t timer, const gptimer_alarm_event_data_t *event, void *context) {
+  int64_t start = esp_timer_get_time();
+
+  if (peltierDriver.setVoltage(setpoints[updates & 0x01])) {           //alternate the output voltage between 1V and 2V
+    errors = errors + 1;
+  }
+
+  uint32_t duration = static_cast<uint32_t>(esp_timer_get_time() - start);
+  if (duration > worstDuration) {
+    worstDuration = duration;
+  }
+  if (lastUpdate != 0 && static_cast<uint32_t>(start - lastUpdate) > worstInterval) {
+    worstInterval = static_cast<uint32_t>(start - lastUpdate);
+  }
+  lastUpdate = start;
+  updates = updates + 1;
+
+  return false;
+}
+
+void setup() {
+  Serial.begin(115200);
+  delay(5000);
+
+  LittleFS.begin(true);                                                 //mount LittleFS and format it if required
+
+  peltierDriver.begin();                                                //initialize the SPI interface with the standard pins
+  peltierDriver.softStart();                                            //softstart of the LT8722 (resets all registers)
+  peltierDriver.setPositiveVoltageLimit(VOLTAGE_LIMIT::LIMIT_5_00);     //set the positive voltage limit to 5V
+  peltierDriver.setNegativeVoltageLimit(VOLTAGE_LIMIT::LIMIT_5_00);     //set the negative voltage limit to -5V
+
+  //periodic timer with a resolution of 1us that calls setpointISR() every PERIOD_US
+  gptimer_config_t timerConfig = {};
+  timerConfig.clk_src = GPTIMER_CLK_SRC_DEFAULT;
+  timerConfig.direction = GPTIMER_COUNT_UP;
+  timerConfig.resolution_hz = 1000000;
+
+  gptimer_alarm_config_t alarmConfig = {};
+  alarmConfig.alarm_count = PERIOD_US;
+  alarmConfig.reload_count = 0;
+  alarmConfig.flags.auto_reload_on_alarm = true;
+
+  gptimer_event_callbacks_t callbacks = {};
+  callbacks.on_alarm = setpointISR;
+
+  bool error = gptimer_new_timer(&timerConfig, &timer) != ESP_OK;
+  error |= gptimer_set_alarm_action(timer, &alarmConfig) != ESP_OK;
+  error |= gptimer_register_event_callbacks(timer, &callbacks, NULL) != ESP_OK;
+  error |= gptimer_enable(timer) != ESP_OK;
+  error |= gptimer_start(timer) != ESP_OK;
+
+  if (error) {
+    Serial.println("Timer could not be started");
+  }
+}
+
+void loop() {
+  uint8_t block[512];
+  memset(block, 0x55, sizeof(block));
+
+  //keep the flash busy for one second
+  uint32_t start = millis();
+  while (millis() - start < 1000) {
+    fs::File file = LittleFS.open("/log.bin", FILE_APPEND);
+    file.write(block, sizeof(block));
+    file.close();
+  }
+  LittleFS.remove("/log.bin");
+
+  Serial.print("Updates: ");
+  Serial.print((unsigned long)updates);
+  Serial.print(" Errors: ");
+  Serial.print((unsigned long)errors);
+  Serial.print(" Worst-case interval [us]: ");
+  Serial.print((unsigned long)worstInterval);
+  Serial.print(" Worst-case duration [us]: ");
+  Serial.println((unsigned long)worstDuration);
+
+  updates = 0;
+  errors = 0;
+  worstInterval = 0;
+  worstDuration = 0;
+}
@@ -0,0 +1,65 @@
+/*
+ * File Name: Scheduled_Setpoints.cpp
+ * Description: The following code is an example for the LT8722 library. This
+ *              example applies a staircase of output voltages to two
+ *              devices at fixed timestamps, e.g. to step the temperature in
+ *              sync with an external instrument. Every step is queued in
+ *              advance with LT8722Scheduler and sent by the timer at its
+ *              due time, while the loop only refills the queue and prints
+ *              the observed issue-time error.
+ *
+ * Revision History:
+ * Date: 2026-10-18 Author: Jan kleine Piening Comments: Initial version created
+ *
+ * Author: Jan kleine Piening Start Date: 2026-10-18
+ *
+ * Notes: This code was written as part of my master's thesis at the
+ *        Institute for Microsensors, -actuators and -systems (IMSAS)
+ *        at the University of Bremen.
+ */
+
+#include <Arduino.h>
+#include <LT8722.h>
+#include <LT8722Scheduler.h>
+
+#define STEP_US  500000                                                 //time between two steps
+#define STEPS    8                                                      //steps of the staircase
+
+LT8722 peltierDriver1;                                                  //create a LT8722 object with FSPI
+LT8722 peltierDriver2;                                                  //create a LT8722 object with FSPI
+LT8722 *devices[] = {&peltierDriver1, &peltierDriver2};
+LT8722Scheduler scheduler;
+
+int64_t nextStep;
+uint32_t step = 0;
+
+void setup() {
+  Serial.begin(115200);
+  delay(5000);
+
+  peltierDriver1.begin(13, 11, 12, 10);
+  peltierDriver2.begin(13, 11, 12, 9);
+  peltierDriver1.softStart();
+  peltierDriver2.softStart();
+
+  scheduler.begin(devices, 2);
+  nextStep = LT8722Scheduler::getTime() + STEP_US;
+}
+
+void loop() {
+  //keep the queue filled one step ahead
+  while (scheduler.getPending() < 4) {
+    double voltage = 0.5 * (step % STEPS);
+    scheduler.schedule(0, nextStep, LT8722::voltageCode(LT8722::Volts(voltage)));
+    scheduler.schedule(1, nextStep, LT8722::voltageCode(LT8722::Volts(-voltage)));
+    nextStep += STEP_US;
+    step++;
+  }
+
+  static uint32_t lastPrint = 0;
+  if (millis() - lastPrint >= 1000) {
+    lastPrint = millis();
+    Serial.printf("issued: %u, failed: %u, mean error: %.1fus, max error: %uus\n", scheduler.getIssued(),
+                  scheduler.getFailed(), scheduler.getMeanError(), scheduler.getMaxError());
+  }
+}
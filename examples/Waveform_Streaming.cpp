@@ -0,0 +1,91 @@
+/*
+ * File Name: Waveform_Streaming.cpp
+ * Description: The following code is an example for the LT8722 library. This
+ *              example plays a sine on the output voltage without the CPU
+ *              sending any frame. After the softstart over SPI, one period
+ *              of setpoint frames is encoded once into a bit stream, which
+ *              the LCD peripheral of the ESP32-S3 clocks out by DMA. The
+ *              loop only copies the next part of the period into the buffer
+ *              that has been sent.
+ *
+ * Revision History:
+ * Date: 2026-10-18 Author: Jan kleine Piening Comments: Initial version created
+ * Date: 2026-10-18 Author: Jan kleine Piening Comments: Allocation and start of the stream checked
+ *
+ * Author: Jan kleine Piening Start Date: 2026-10-18
+ *
+ * Notes: This code was written as part of my master's thesis at the
+ *        Institute for Microsensors, -actuators and -systems (IMSAS)
+ *        at the University of Bremen.
+ */
+
+#include <Arduino.h>
+#include <LT8722.h>
+#include <LT8722Stream.h>
+
+#define POINTS    256                                                   //setpoints per period
+#define OFFSET    2.0                                                   //offset of the sine in volts
+#define AMPLITUDE 1.0                                                   //amplitude of the sine in volts
+#define GAP       366                                                   //idle samples after every frame => 62µs per setpoint at 8MHz
+
+const uint8_t pins[8] = {12, 11, 10, 4, 5, 6, 7, 15};                   //SCK, MOSI, CS of lane 0 and free GPIOs for lane 1 to 5
+
+LT8722 peltierDriver;                                                   //create a LT8722 object with FSPI
+LT8722Stream stream;
+LT8722Bitstream encoder({1, 1, GAP});
+
+uint8_t *period;                                                        //encoded setpoint frames of one period
+uint32_t frameSamples;
+uint32_t position = 0;
+
+uint32_t fill(uint8_t *buffer, uint32_t capacity, void *context) {
+  uint32_t frames = capacity / frameSamples;                            //only whole frames, so every buffer ends idle
+  uint32_t length = 0;
+
+  for (uint32_t i = 0; i < frames; i++) {
+    memcpy(buffer + length, period + position * frameSamples, frameSamples);
+    length += frameSamples;
+    position = (position + 1) % POINTS;
+  }
+
+  return length;
+}
+
+void setup() {
+  Serial.begin(115200);
+  delay(5000);
+
+  peltierDriver.begin(13, 11, 12, 10);
+  peltierDriver.softStart();
+
+  //encode one period of the sine once
+  frameSamples = encoder.getFrameSamples(8);
+  period = (uint8_t *)ps_malloc(POINTS * frameSamples);
+  if (period == NULL) {
+    Serial.println("Not enough PSRAM for one period");
+    return;
+  }
+  for (uint32_t i = 0; i < POINTS; i++) {
+    double voltage = OFFSET + AMPLITUDE * sin(2 * M_PI * i / POINTS);
+    uint32_t code = LT8722::voltageCode(LT8722::Volts(voltage)).value;
+    encoder.encodeSetpoint(0, code, period + i * frameSamples, frameSamples);
+  }
+
+  if (stream.begin(pins, 16, 17, 4000000, 32 * frameSamples)) {          //error if the LCD peripheral or the DMA buffers are not available
+    Serial.println("Stream could not be initialized");
+    return;
+  }
+  if (stream.start(fill, NULL)) {
+    Serial.println("Stream could not be started");
+  }
+}
+
+void loop() {
+  stream.service();
+
+  static uint32_t lastPrint = 0;
+  if (millis() - lastPrint >= 1000) {
+    lastPrint = millis();
+    Serial.printf("buffers: %u, underruns: %u\n", stream.getBuffers(), stream.getUnderruns());
+  }
+}
@@ -12,6 +12,20 @@
 
 #include "LT8722.h"
 #include "LT8722SPI.h"
+#include <driver/gpio.h>
+#include <esp_timer.h>
+#include <esp_rom_sys.h>
+
+#ifdef LT8722_FAULT_INJECTION
+#include "LT8722FaultInjection.h"
+#endif
+
+LT8722* LT8722::_devices[LT8722_MAX_DEVICES];
+uint8_t LT8722::_deviceCount = 0;
+portMUX_TYPE LT8722::_deviceLock = portMUX_INITIALIZER_UNLOCKED;
+const void* LT8722::_analogInputOwners[LT8722_ANALOG_INPUTS];
+volatile uint32_t LT8722::_emergencyOffDevices = 0;
+volatile uint32_t LT8722::_emergencyOffTime = 0;
 
 /**************************************************************************/
 /*!
@@ -22,21 +36,71 @@
 LT8722::LT8722(uint8_t spi_bus) {
     if(spi_bus == HSPI) {
         spi = new SPIClass(HSPI);
+        _spiBus = HSPI;
     } else {
         spi = new SPIClass(FSPI);
+        _spiBus = FSPI;
     }
+
+    //until the command register is known, the emergency shutdown clears the whole command register
+    uint8_t command[] = {0x00, 0x00, 0x00, 0x00};
+    _offFrameIndex = 0;
+    updateCommand(command);
+
+    _idleTimeout = 0;
+    _idleThreshold = 0;
+    _nearZeroSince = 0;
+    _idleStart = 0;
+    _idleTime = 0;
+    _wakeLatency = 0;
+    _nearZero = false;
+    _idle = false;
+    _shutDown = false;
+
+    _setpoint = 0;
+    _registerMask = 0;
+    _recoveryTime = 0;
+
+    _compliance = VOLTAGE_LIMIT::LIMIT_1_25;
+    _currentDirection = 0;
+    _currentMode = false;
+}
+
+/**************************************************************************/
+/*!
+    @brief Remove the LT8722 object from the emergency shutdown
+*/
+/**************************************************************************/
+LT8722::~LT8722() {
+    //the slot is cleared under the lock, so a running emergency shutdown never uses a destroyed object
+    portENTER_CRITICAL(&_deviceLock);
+    for (uint8_t i = 0; i < _deviceCount; i++) {
+        if (_devices[i] == this) {
+            _devices[i] = NULL;
+        }
+    }
+    while (_deviceCount > 0 && _devices[_deviceCount - 1] == NULL) {
+        _deviceCount--;
+    }
+    portEXIT_CRITICAL(&_deviceLock);
+
+    //the SPI object is kept, ending it would stop the bus of other devices on the same pins
 }
 
 /**************************************************************************/
 /*!
-    @brief Initialize the SPI interface
+    @brief Initialize the SPI interface and register the device for the 
+           emergency shutdown
     @param miso the SPI MISO pin to use
     @param mosi the SPI MOSI pin to use
     @param sck the SPI clock pin to use
     @param cs the SPI CS pin to use
+    @return Error (True) if an error accrued during the SPI communication
+            or the device could not be registered for the emergency 
+            shutdown (more than LT8722_MAX_DEVICES devices)
 */
 /**************************************************************************/
-void LT8722::begin(uint8_t miso, uint8_t mosi, uint8_t sck, uint8_t cs, uint8_t analogInput) {
+bool LT8722::begin(uint8_t miso, uint8_t mosi, uint8_t sck, uint8_t cs, uint8_t analogInput) {
     spi->begin(sck, miso, mosi, cs);
 
     pinMode(cs, OUTPUT);
@@ -45,8 +109,46 @@ void LT8722::begin(uint8_t miso, uint8_t mosi, uint8_t sck, uint8_t cs, uint8_t
 
     _analogInput = analogInput;
 
-    resetRegisters(spi, _cs);
+#ifdef LT8722_USE_IRAM
+    //frames are sent without transactions, so the bus settings have to be applied once
+    spi->beginTransaction(SPISettings(4000000, MSBFIRST, SPI_MODE0));
+    spi->endTransaction();
+#endif
+
+    //the bus is registered before the first frame, transferFrameDirect() sends nothing on an unknown bus
+    bool error = attachFrameBus(spi, _spiBus);
+
+    uint8_t command[4];
+    struct dataSPI dataPacket = resetRegisters(spi, _cs, command);
     resetStatusRegister(spi, _cs);
+
+    if (!dataPacket.error) {
+        updateCommand(command);
+    }
+
+    //register the device for the emergency shutdown in the first free slot
+    int16_t slot = -1;
+
+    portENTER_CRITICAL(&_deviceLock);
+    for (uint8_t i = 0; i < _deviceCount; i++) {
+        if (_devices[i] == this) {
+            slot = i;
+            break;
+        }
+        if (_devices[i] == NULL && slot < 0) {
+            slot = i;
+        }
+    }
+    if (slot < 0 && _deviceCount < LT8722_MAX_DEVICES) {
+        slot = _deviceCount;
+        _deviceCount++;
+    }
+    if (slot >= 0) {
+        _devices[slot] = this;
+    }
+    portEXIT_CRITICAL(&_deviceLock);
+
+    return error || slot < 0 || dataPacket.error;
 }
 
 /**************************************************************************/
@@ -57,6 +159,11 @@ void LT8722::begin(uint8_t miso, uint8_t mosi, uint8_t sck, uint8_t cs, uint8_t
 /**************************************************************************/
 bool LT8722::softStart() {
 
+    uint8_t command[4];
+
+    //only a softstart releases the latch of an emergency shutdown
+    _shutDown = false;
+
     //softstart procedure 
     struct dataSPI dataPacket0 = resetRegisters(spi, _cs);
     struct dataSPI dataPacket1 = resetStatusRegister(spi, _cs);
@@ -65,10 +172,17 @@ bool LT8722::softStart() {
     struct dataSPI dataPacket4 = resetStatusRegister(spi, _cs);
     delay(2);
     struct dataSPI dataPacket5 = rampOutputVoltage(spi, _cs, 2.5, 1.25, 0.01, 20);
-    struct dataSPI dataPacket6 = setCommandRegister(spi, _cs, COMMAND_REG::SWEN_REQ, ENABLE);
+    struct dataSPI dataPacket6 = setCommandRegister(spi, _cs, COMMAND_REG::SWEN_REQ, ENABLE, command);
     struct dataSPI dataPacket7 = resetStatusRegister(spi, _cs);
     delay(2);
 
+    if (!dataPacket6.error) {
+        updateCommand(command);
+    }
+    _idle = false;
+    _setpoint = 0;
+    _registerMask = 0;
+
     //check for communication errors
     if (dataPacket0.error ||
         dataPacket1.error ||
@@ -91,9 +205,17 @@ bool LT8722::softStart() {
 */
 /**************************************************************************/
 bool LT8722::reset() {
-    struct dataSPI dataPacket0 = resetRegisters(spi, _cs);
+    uint8_t command[4];
+    struct dataSPI dataPacket0 = resetRegisters(spi, _cs, command);
     struct dataSPI dataPacket1 = resetStatusRegister(spi, _cs);
 
+    if (!dataPacket0.error) {
+        updateCommand(command);
+    }
+    _idle = false;
+    _setpoint = 0;
+    _registerMask = 0;
+
     //check for communication errors
     if (dataPacket0.error || dataPacket1.error) {
         return true;
@@ -110,10 +232,16 @@ bool LT8722::reset() {
 */
 /**************************************************************************/
 bool LT8722::powerOff() {
+    uint8_t command[4];
     struct dataSPI dataPacket0 = setCommandRegister(spi, _cs, COMMAND_REG::ENABLE_REQ, DISABLE);
-    struct dataSPI dataPacket1 = setCommandRegister(spi, _cs, COMMAND_REG::SWEN_REQ, DISABLE);
+    struct dataSPI dataPacket1 = setCommandRegister(spi, _cs, COMMAND_REG::SWEN_REQ, DISABLE, command);
     struct dataSPI dataPacket2 = resetStatusRegister(spi, _cs);
 
+    if (!dataPacket1.error) {
+        updateCommand(command);
+    }
+    _idle = false;
+
     //check for communication errors
     if (dataPacket0.error || dataPacket1.error || dataPacket2.error) {
         return true;
@@ -130,14 +258,74 @@ bool LT8722::powerOff() {
 */
 /**************************************************************************/
 bool LT8722::setVoltage(double voltage) {
-    double voltageDAC = (voltage / -16) + 1.25; //convert the voltage to fit the specifications of the L8722
+    //the register value is calculated once, so the idle tracking and the written value always match
+    return setVoltage(voltageCode(Volts(voltage)));
+}
+
+/**************************************************************************/
+/*!
+    @brief Set the output voltage with a precalculated register value.
+           With LT8722_USE_IRAM the whole path runs from IRAM, so it can
+           be called from an IRAM interrupt during flash writes.
+    @param code Register value from voltageCode()
+    @return Error (True) if an error accrued during the SPI communication
+*/
+/**************************************************************************/
+bool LT8722_IRAM_ATTR LT8722::setVoltage(VoltageCode code) {
+    _setpoint = code.value;
+
+    //near-zero setpoints keep an idle device idle, only the DAC register is written
+    if (_idleTimeout != 0) {
+        trackSetpoint(code.value);
+        if (_idle && !_nearZero) {
+            return wake(code.value);
+        }
+    }
 
-    struct dataSPI dataPacket = setOutputVoltage(spi, _cs, voltageDAC);
+    struct dataSPI dataPacket = setOutputVoltageRegister(spi, _cs, code.value);
 
     //check for communication errors
     return dataPacket.error;
 }
 
+/**************************************************************************/
+/*!
+    @brief Set the output voltage with a write frame of the SPIS_DAC 
+           register that was already encoded with encodeWriteFrame(), so
+           no calculation is left at the time the frame is sent
+    @param frame Encoded write frame with a length of eight bytes
+    @param code Register value contained in the frame
+    @param start Output, time right before the chip select goes low in
+           microseconds (esp_timer_get_time()), NULL if not needed
+    @return Error (True) if the frame was not acknowledged or the CRC of
+            the answer is wrong
+*/
+/**************************************************************************/
+bool LT8722_IRAM_ATTR LT8722::setVoltageFrame(const uint8_t *frame, uint32_t code, int64_t *start) {
+    _setpoint = code;
+
+    if (start != NULL) {
+        *start = esp_timer_get_time();              //overwritten by the transfer, the wake ramp starts now
+    }
+
+    if (_idleTimeout != 0) {
+        trackSetpoint(code);
+        if (_idle && !_nearZero) {
+            return wake(code);
+        }
+    }
+
+    struct dataSPI dataPacket;
+    uint8_t sendingPacket[8];
+
+    memcpy(sendingPacket, frame, 8);                //the queued frame stays untouched
+    dataPacket.type = FRAME_TYPE::WRITE;
+    transferFrame(spi, _cs, sendingPacket, dataPacket.frame, 8, start);
+
+    //check for communication errors
+    return validateFrame(dataPacket);
+}
+
 /**************************************************************************/
 /*!
     @brief Return the data of the status register, bit [10-0]
@@ -149,7 +337,7 @@ uint16_t LT8722::getStatus() {
 
     struct dataSPI dataPacket = readStatus(spi, _cs);
 
-    status = (static_cast<uint16_t>(dataPacket.status[0]) << 8) | dataPacket.status[1]; //convert status byte array to uint16_t 
+    status = dataPacket.getStatus();
 
     return status;
 }
@@ -165,7 +353,7 @@ uint32_t LT8722::getCommand() {
 
     struct dataSPI dataPacket = readRegister(spi, _cs, 0x00);
 
-    data = (static_cast<uint32_t>(dataPacket.data[0]) << 24) | (static_cast<uint32_t>(dataPacket.data[1]) << 16) | (static_cast<uint16_t>(dataPacket.data[2]) << 8) | dataPacket.data[3]; //convert data byte array to uint32_t 
+    data = dataPacket.getData();
 
     return data;
 }
@@ -183,6 +371,11 @@ bool LT8722::setPositiveVoltageLimit(VOLTAGE_LIMIT limit) {
 
     struct dataSPI dataPacket = writeRegister(spi, _cs, 0x05, data);
 
+    //only an acknowledged write changes the register
+    if (!dataPacket.error) {
+        cacheRegister(0x05, limitValue);
+    }
+
     //check for communication errors
     return dataPacket.error;
 }
@@ -202,6 +395,11 @@ bool LT8722::setNegativeVoltageLimit(VOLTAGE_LIMIT limit) {
 
     struct dataSPI dataPacket = writeRegister(spi, _cs, 0x06, data);
 
+    //only an acknowledged write changes the register
+    if (!dataPacket.error) {
+        cacheRegister(0x06, limitValue);
+    }
+
     //check for communication errors
     return dataPacket.error;
 }
@@ -214,16 +412,34 @@ bool LT8722::setNegativeVoltageLimit(VOLTAGE_LIMIT limit) {
 */
 /**************************************************************************/
 bool LT8722::setPositiveCurrentLimit(double limit) {
-    uint8_t data[4];
     uint16_t currentLimit = -((limit - 6.8) / 0.01328); //convert the current limit to fit the specifications of the L8722
+
+    return setPositiveCurrentLimit(CurrentCode(currentLimit));
+}
+
+/**************************************************************************/
+/*!
+    @brief Define the maximum positive current limit with a precalculated 
+           register value
+    @param code Register value from positiveCurrentCode()
+    @return Error (True) if an error accrued during the SPI communication
+*/
+/**************************************************************************/
+bool LT8722::setPositiveCurrentLimit(CurrentCode code) {
+    uint8_t data[4];
     
     data[0] = 0x00;
     data[1] = 0x00;
-    data[2] = currentLimit >> 8;
-    data[3] = currentLimit;
+    data[2] = code.value >> 8;
+    data[3] = code.value;
 
     struct dataSPI dataPacket = writeRegister(spi, _cs, 0x03, data);
 
+    //only an acknowledged write changes the register
+    if (!dataPacket.error) {
+        cacheRegister(0x03, code.value);
+    }
+
     //check for communication errors
     return dataPacket.error;
 }
@@ -236,16 +452,34 @@ bool LT8722::setPositiveCurrentLimit(double limit) {
 */
 /**************************************************************************/
 bool LT8722::setNegativeCurrentLimit(double limit) {
-    uint8_t data[4];
     uint16_t currentLimit = -(-limit / 0.01328); //convert the current limit to fit the specifications of the L8722
+
+    return setNegativeCurrentLimit(CurrentCode(currentLimit));
+}
+
+/**************************************************************************/
+/*!
+    @brief Define the maximum negative current limit with a precalculated 
+           register value
+    @param code Register value from negativeCurrentCode()
+    @return Error (True) if an error accrued during the SPI communication
+*/
+/**************************************************************************/
+bool LT8722::setNegativeCurrentLimit(CurrentCode code) {
+    uint8_t data[4];
     
     data[0] = 0x00;
     data[1] = 0x00;
-    data[2] = currentLimit >> 8;
-    data[3] = currentLimit;
+    data[2] = code.value >> 8;
+    data[3] = code.value;
 
     struct dataSPI dataPacket = writeRegister(spi, _cs, 0x02, data);
 
+    //only an acknowledged write changes the register
+    if (!dataPacket.error) {
+        cacheRegister(0x02, code.value);
+    }
+
     //check for communication errors
     return dataPacket.error;
 }
@@ -259,7 +493,12 @@ bool LT8722::setNegativeCurrentLimit(double limit) {
 /**************************************************************************/
 bool LT8722::setPWMFreq(PWM_MHZ value){
     uint8_t freqValue = static_cast<uint8_t>(value);
-    struct dataSPI dataPacket = setCommandRegister(spi, _cs, COMMAND_REG::SW_FRQ_SET, freqValue);
+    uint8_t command[4];
+    struct dataSPI dataPacket = setCommandRegister(spi, _cs, COMMAND_REG::SW_FRQ_SET, freqValue, command);
+
+    if (!dataPacket.error) {
+        updateCommand(command);
+    }
 
     return dataPacket.error;
 }
@@ -273,7 +512,12 @@ bool LT8722::setPWMFreq(PWM_MHZ value){
 /**************************************************************************/
 bool LT8722::setPWMAdjust(PWM_ADJ value){
     uint8_t adjValue = static_cast<uint8_t>(value);
-    struct dataSPI dataPacket = setCommandRegister(spi, _cs, COMMAND_REG::SW_FRQ_ADJ, adjValue);
+    uint8_t command[4];
+    struct dataSPI dataPacket = setCommandRegister(spi, _cs, COMMAND_REG::SW_FRQ_ADJ, adjValue, command);
+
+    if (!dataPacket.error) {
+        updateCommand(command);
+    }
 
     return dataPacket.error;
 }
@@ -287,7 +531,12 @@ bool LT8722::setPWMAdjust(PWM_ADJ value){
 /**************************************************************************/  
 bool LT8722::setPWMDutyCycle(PWM_DUTY value){
     uint8_t dutyValue = static_cast<uint8_t>(value);
-    struct dataSPI dataPacket = setCommandRegister(spi, _cs, COMMAND_REG::SYS_DC, dutyValue);
+    uint8_t command[4];
+    struct dataSPI dataPacket = setCommandRegister(spi, _cs, COMMAND_REG::SYS_DC, dutyValue, command);
+
+    if (!dataPacket.error) {
+        updateCommand(command);
+    }
 
     return dataPacket.error;
 }
@@ -301,7 +550,12 @@ bool LT8722::setPWMDutyCycle(PWM_DUTY value){
 /**************************************************************************/  
 bool LT8722::setLDOVoltage(LDO_VOLTAGE value){
     uint8_t voltageValue = static_cast<uint8_t>(value);
-    struct dataSPI dataPacket = setCommandRegister(spi, _cs, COMMAND_REG::VCC_VREG, voltageValue);
+    uint8_t command[4];
+    struct dataSPI dataPacket = setCommandRegister(spi, _cs, COMMAND_REG::VCC_VREG, voltageValue, command);
+
+    if (!dataPacket.error) {
+        updateCommand(command);
+    }
 
     return dataPacket.error;
 }
@@ -315,7 +569,12 @@ bool LT8722::setLDOVoltage(LDO_VOLTAGE value){
 /**************************************************************************/  
 bool LT8722::setPeakInductor(INDUCTOR_CURRENT value){
     uint8_t currentValue = static_cast<uint8_t>(value);
-    struct dataSPI dataPacket = setCommandRegister(spi, _cs, COMMAND_REG::SW_VC_INT, currentValue);
+    uint8_t command[4];
+    struct dataSPI dataPacket = setCommandRegister(spi, _cs, COMMAND_REG::SW_VC_INT, currentValue, command);
+
+    if (!dataPacket.error) {
+        updateCommand(command);
+    }
 
     return dataPacket.error;
 }
@@ -329,7 +588,12 @@ bool LT8722::setPeakInductor(INDUCTOR_CURRENT value){
 /**************************************************************************/
 bool LT8722::setPowerLimit(POWER_LIMIT value){
     uint8_t powerValue = static_cast<uint8_t>(value);
-    struct dataSPI dataPacket = setCommandRegister(spi, _cs, COMMAND_REG::PWR_LIM, powerValue);
+    uint8_t command[4];
+    struct dataSPI dataPacket = setCommandRegister(spi, _cs, COMMAND_REG::PWR_LIM, powerValue, command);
+
+    if (!dataPacket.error) {
+        updateCommand(command);
+    }
 
     return dataPacket.error;
 }
@@ -338,7 +602,8 @@ bool LT8722::setPowerLimit(POWER_LIMIT value){
 /*!
     @brief Read the selected value of the analog output pin
     @param value Predefined value to be read
-    @return value of the selected analog output
+    @return value of the selected analog output, NAN if the analog 
+            input is locked by another device or a LT8722SharedOutput
 */
 /**************************************************************************/
 double LT8722::readAnalogOutput(ANALOG_OUTPUT value){
@@ -348,6 +613,11 @@ double LT8722::readAnalogOutput(ANALOG_OUTPUT value){
     double voltage1P25 = 0.0;
     double voltage1P65 = 0.0;
 
+    //the line may be driven by another device with the same analog input
+    if (lockAnalogInput(_analogInput, this)) {
+        return NAN;
+    }
+
     //read and convert voltage according to the requested value
     switch (value)
     {
@@ -358,13 +628,13 @@ double LT8722::readAnalogOutput(ANALOG_OUTPUT value){
         voltage = analogReadMilliVolts(_analogInput);
         voltage /= 1000;
 
-        setAnalogOutput(spi, _cs, 0x6);
+        setAnalogOutput(spi, _cs, static_cast<uint8_t>(ANALOG_OUTPUT::REFERENCE_1_25));
         delay(10);
         voltage1P25 = analogReadMilliVolts(_analogInput);
         voltage1P25 /= 1000;
         disableAnalogOutput(spi, _cs);
 
-        output = (-voltage + voltage1P25) * 16;
+        output = convertAnalogOutput(value, voltage, voltage1P25);
         break;
     case ANALOG_OUTPUT::CURRENT:
         enableAnalogOutput(spi, _cs);
@@ -373,13 +643,13 @@ double LT8722::readAnalogOutput(ANALOG_OUTPUT value){
         voltage = analogReadMilliVolts(_analogInput);
         voltage /= 1000;
 
-        setAnalogOutput(spi, _cs, 0x7);
+        setAnalogOutput(spi, _cs, static_cast<uint8_t>(ANALOG_OUTPUT::REFERENCE_1_65));
         delay(10);
         voltage1P65 = analogReadMilliVolts(_analogInput);
         voltage1P65 /= 1000;
         disableAnalogOutput(spi, _cs);
 
-        output = (-voltage + voltage1P65) * 8;
+        output = convertAnalogOutput(value, voltage, voltage1P65);
         break;
     case ANALOG_OUTPUT::TEMPERATURE:
         enableAnalogOutput(spi, _cs);
@@ -389,12 +659,928 @@ double LT8722::readAnalogOutput(ANALOG_OUTPUT value){
         voltage /= 1000;
         disableAnalogOutput(spi, _cs);
 
-        output = (voltage - 1.421125) / 0.004715;
+        output = convertAnalogOutput(value, voltage, 0.0);
         break;
     default:
         output = 0.0;
         break;
     }
 
+    unlockAnalogInput(_analogInput, this);
+
     return output;
-}
\ No newline at end of file
+}
+/**************************************************************************/
+/*!
+    @brief Enable the analog output and keep it on the selected value, 
+           e.g. for a continuous capture of the analog output pin
+    @param value Predefined value to be selected
+    @return Error (True) if an error accrued during the SPI communication
+*/
+/**************************************************************************/
+bool LT8722::parkAnalogOutput(ANALOG_OUTPUT value) {
+    uint8_t data[] = {0x00, 0x00, 0x00, static_cast<uint8_t>(0x40 | static_cast<uint8_t>(value))}; //AOUT_EN and AMUX[3:0]
+
+    struct dataSPI dataPacket = writeRegister(spi, _cs, 0x07, data);
+
+    //check for communication errors
+    return dataPacket.error;
+}
+
+/**************************************************************************/
+/*!
+    @brief Disable the analog output after parkAnalogOutput()
+    @return Error (True) if an error accrued during the SPI communication
+*/
+/**************************************************************************/
+bool LT8722::releaseAnalogOutput() {
+    uint8_t data[] = {0x00, 0x00, 0x00, 0x00};  //default value of the SPIS_AMUX register
+
+    struct dataSPI dataPacket = writeRegister(spi, _cs, 0x07, data);
+
+    //check for communication errors
+    return dataPacket.error;
+}
+
+/**************************************************************************/
+/*!
+    @brief Select a value of the AMUX while the analog output stays 
+           disabled (high impedance), e.g. to prepare a device on a 
+           shared analog output line
+    @param value Predefined value to be selected
+    @return Error (True) if an error accrued during the SPI communication
+*/
+/**************************************************************************/
+bool LT8722::selectAnalogOutput(ANALOG_OUTPUT value) {
+    uint8_t data[] = {0x00, 0x00, 0x00, static_cast<uint8_t>(value)};      //AOUT_EN cleared and AMUX[3:0]
+
+    struct dataSPI dataPacket = writeRegister(spi, _cs, 0x07, data);
+
+    //check for communication errors
+    return dataPacket.error;
+}
+
+/**************************************************************************/
+/*!
+    @brief Return the pin connected to the analog output of the LT8722
+    @return Analog input pin given to begin()
+*/
+/**************************************************************************/
+uint8_t LT8722::getAnalogInput() {
+    return _analogInput;
+}
+
+/**************************************************************************/
+/*!
+    @brief Lock an analog input pin, so that only one owner drives the
+           analog output line connected to it (e.g. readAnalogOutput()
+           or a LT8722SharedOutput)
+    @param pin Analog input pin
+    @param owner Object that takes the lock
+    @return Error (True) if the pin is locked by another owner
+*/
+/**************************************************************************/
+bool LT8722::lockAnalogInput(uint8_t pin, const void *owner) {
+    bool error = true;
+
+    if (pin >= LT8722_ANALOG_INPUTS) {
+        return true;
+    }
+
+    portENTER_CRITICAL(&_deviceLock);
+    if (_analogInputOwners[pin] == NULL || _analogInputOwners[pin] == owner) {
+        _analogInputOwners[pin] = owner;
+        error = false;
+    }
+    portEXIT_CRITICAL(&_deviceLock);
+
+    return error;
+}
+
+/**************************************************************************/
+/*!
+    @brief Unlock an analog input pin locked by lockAnalogInput()
+    @param pin Analog input pin
+    @param owner Object that took the lock
+*/
+/**************************************************************************/
+void LT8722::unlockAnalogInput(uint8_t pin, const void *owner) {
+    if (pin >= LT8722_ANALOG_INPUTS) {
+        return;
+    }
+
+    portENTER_CRITICAL(&_deviceLock);
+    if (_analogInputOwners[pin] == owner) {
+        _analogInputOwners[pin] = NULL;
+    }
+    portEXIT_CRITICAL(&_deviceLock);
+}
+
+/**************************************************************************/
+/*!
+    @brief Convert the voltage of the analog output pin to the selected
+           value, as done by readAnalogOutput()
+    @param value Predefined value of the analog output
+    @param voltage Voltage of the analog output pin in volts
+    @param reference Voltage of the 1.25V (VOLTAGE) or 1.65V (CURRENT)
+           reference in volts, not used for TEMPERATURE
+    @return Converted value of the selected analog output
+*/
+/**************************************************************************/
+double LT8722::convertAnalogOutput(ANALOG_OUTPUT value, double voltage, double reference) {
+    switch (value)
+    {
+    case ANALOG_OUTPUT::VOLTAGE:
+        return (-voltage + reference) * 16;
+    case ANALOG_OUTPUT::CURRENT:
+        return (-voltage + reference) * 8;
+    case ANALOG_OUTPUT::TEMPERATURE:
+        return (voltage - 1.421125) / 0.004715;
+    default:
+        return voltage;
+    }
+}
+
+/**************************************************************************/
+/*!
+    @brief Switch to current-mode control: the voltage limits are set to
+           the compliance voltage and the output current is regulated by 
+           the current limiter of the LT8722 with setCurrent()
+    @param compliance Predefined voltage limit used as compliance voltage
+    @return Error (True) if an error accrued during the SPI communication
+*/
+/**************************************************************************/
+bool LT8722::enableCurrentMode(VOLTAGE_LIMIT compliance) {
+    bool error = false;
+
+    //no current until the first setpoint
+    error |= setVoltage(VoltageCode(0));
+    error |= setPositiveCurrentLimit(positiveCurrentCodeMilliamps(0));
+    error |= setNegativeCurrentLimit(negativeCurrentCodeMilliamps(0));
+    error |= setPositiveVoltageLimit(compliance);
+    error |= setNegativeVoltageLimit(compliance);
+
+    _compliance = compliance;
+    _currentDirection = 0;
+    _currentMode = !error;
+
+    return error;
+}
+
+/**************************************************************************/
+/*!
+    @brief Set the output current in current mode. The output voltage is
+           driven to the compliance voltage in the direction of the 
+           current and the current limit register of this direction 
+           holds the setpoint, so an update within one direction is a 
+           single frame. A change of direction first reduces the other 
+           current limit to its minimum. The smallest current limit is 
+           LT8722_MIN_CURRENT, so a current below it in both directions
+           sets the output to 0V instead.
+    @param milliamps Output current in mA (negative for reverse current)
+    @return Error (True) if an error accrued during the SPI communication
+            or the current mode is not enabled
+*/
+/**************************************************************************/
+bool LT8722::setCurrent(int32_t milliamps) {
+    if (!_currentMode) {
+        return true;
+    }
+
+    //SPIS_ILIMP = 0x1FF still allows LT8722_MIN_CURRENT at the compliance voltage, so no current needs 0V
+    if (milliamps > -LT8722_MIN_CURRENT && milliamps < LT8722_MIN_CURRENT) {
+        if (_currentDirection == 0) {
+            return false;
+        }
+
+        bool error = setVoltage(VoltageCode(0));
+        error |= setPositiveCurrentLimit(positiveCurrentCodeMilliamps(0));
+        error |= setNegativeCurrentLimit(negativeCurrentCodeMilliamps(0));
+
+        if (!error) {
+            _currentDirection = 0;
+        }
+        return error;
+    }
+
+    int8_t direction = (milliamps >= 0) ? 1 : -1;
+
+    //fast path: only the limit register of the active direction is written
+    if (direction == _currentDirection) {
+        if (direction > 0) {
+            return setPositiveCurrentLimit(positiveCurrentCodeMilliamps(milliamps));
+        }
+        return setNegativeCurrentLimit(negativeCurrentCodeMilliamps(-milliamps));
+    }
+
+    bool error = false;
+    uint32_t compliance = voltageCode(Volts(limitVoltage(_compliance)), _compliance).value;
+    if (compliance > 0xFFFFFF) {
+        compliance = 0xFFFFFF;                          //largest positive value of the 25 bit DAC register
+    }
+
+    //change of direction: the old direction is limited before the output voltage is reversed
+    if (direction > 0) {
+        error |= setNegativeCurrentLimit(negativeCurrentCodeMilliamps(0));
+        error |= setPositiveCurrentLimit(positiveCurrentCodeMilliamps(milliamps));
+        error |= setVoltage(VoltageCode(compliance));
+    } else {
+        error |= setPositiveCurrentLimit(positiveCurrentCodeMilliamps(0));
+        error |= setNegativeCurrentLimit(negativeCurrentCodeMilliamps(-milliamps));
+        error |= setVoltage(VoltageCode(-compliance));
+    }
+
+    _currentDirection = error ? 0 : direction;
+
+    return error;
+}
+
+/**************************************************************************/
+/*!
+    @brief Leave the current mode: the output voltage is set to 0V and 
+           both current limits to their maximum
+    @return Error (True) if an error accrued during the SPI communication
+*/
+/**************************************************************************/
+bool LT8722::disableCurrentMode() {
+    bool error = false;
+
+    error |= setVoltage(VoltageCode(0));
+    error |= setPositiveCurrentLimit(CurrentCode(0x000));
+    error |= setNegativeCurrentLimit(CurrentCode(0x1FF));
+
+    _currentMode = false;
+    _currentDirection = 0;
+
+    return error;
+}
+
+/**************************************************************************/
+/*!
+    @brief Configure the idle manager. If the setpoint stays near zero 
+           for the given time, switching is stopped (SWEN_REQ cleared).
+           The next setpoint restores switching with a short warm ramp
+           from the cached register state instead of a softstart.
+    @param timeout Time in milliseconds near zero before idle (0 = off)
+    @param threshold Setpoints up to this voltage count as near zero
+    @return Error (True) if switching could not be restored when the idle
+            manager is turned off while idle, the settings are kept then
+*/
+/**************************************************************************/
+bool LT8722::setIdle(uint32_t timeout, double threshold) {
+    //no later setpoint wakes the device once the idle manager is off
+    if (timeout == 0 && _idle && wake(_setpoint)) {
+        return true;
+    }
+
+    _idleTimeout = timeout;
+    _idleThreshold = voltageCode(Volts(fabs(threshold))).value;
+    _nearZero = false;
+
+    return false;
+}
+
+/**************************************************************************/
+/*!
+    @brief Enter idle if the setpoint has been near zero long enough, has
+           to be called regularly (e.g. in the loop)
+    @return Error (True) if an error accrued during the SPI communication
+*/
+/**************************************************************************/
+bool LT8722::updateIdle() {
+    uint8_t swen = 1 << static_cast<uint8_t>(COMMAND_REG::SWEN_REQ);
+
+    //only a switching device (after softStart) can go idle
+    if (_idleTimeout == 0 || _idle || _shutDown || !_nearZero || !(_command[3] & swen) ||
+        esp_timer_get_time() - _nearZeroSince < static_cast<int64_t>(_idleTimeout) * 1000) {
+        return false;
+    }
+
+    uint8_t data[4];
+    for (uint8_t i = 0; i < 4; i++) {
+        data[i] = _command[i];
+    }
+    data[3] &= ~swen;
+
+    struct dataSPI dataPacket = writeRegister(spi, _cs, 0x00, data);
+    if (dataPacket.error) {
+        return true;
+    }
+    updateCommand(data);
+
+    _idle = true;
+    _idleStart = esp_timer_get_time();
+
+    return false;
+}
+
+/**************************************************************************/
+/*!
+    @brief Return whether switching is currently stopped by the idle 
+           manager
+    @return True if the device is idle
+*/
+/**************************************************************************/
+bool LT8722::isIdle() {
+    return _idle;
+}
+
+/**************************************************************************/
+/*!
+    @brief Return the total time spent in idle, which is the time the 
+           switching losses were saved
+    @return Idle time in milliseconds
+*/
+/**************************************************************************/
+uint32_t LT8722::getIdleTime() {
+    if (_idle) {
+        return static_cast<uint32_t>((_idleTime + (esp_timer_get_time() - _idleStart)) / 1000);
+    }
+    return static_cast<uint32_t>(_idleTime / 1000);
+}
+
+/**************************************************************************/
+/*!
+    @brief Return the duration of the last wake-up from idle
+    @return Time in microseconds from the setpoint call until the new 
+            setpoint was reached
+*/
+/**************************************************************************/
+uint32_t LT8722::getWakeLatency() {
+    return _wakeLatency;
+}
+
+/**************************************************************************/
+/*!
+    @brief Check the device for faults: communication (acknowledge and 
+           CRC), latched overcurrent or thermal shutdown in the status
+           register, a command register that no longer matches the state
+           set by the library (both enable bits cleared after 
+           emergencyOff()) and optionally a stuck analog output
+    @param checkAnalogOutput Also check the 1.25V reference on the analog 
+           output (takes about 2ms), ANALOG_INPUT_LOCKED is returned 
+           if another owner holds the analog input
+    @return Detected fault, NONE if the device is healthy
+*/
+/**************************************************************************/
+FAULT LT8722::checkHealth(bool checkAnalogOutput) {
+    struct dataSPI statusPacket = readStatus(spi, _cs);
+
+    if (statusPacket.getAck() != 0xA5) {
+        return FAULT::NO_ACK;
+    }
+    if (statusPacket.error) {
+        return FAULT::CRC_ERROR;
+    }
+    if (statusPacket.getStatus() & 0x20) {
+        return FAULT::OVER_CURRENT;
+    }
+    if (statusPacket.getStatus() & 0x40) {
+        return FAULT::OVER_TEMPERATURE;
+    }
+
+    //the enable bits of the command register are compared with the cached state, both are cleared after an emergency shutdown
+    struct dataSPI commandPacket = readRegister(spi, _cs, 0x00);
+    uint8_t enable = _shutDown ? 0x00 : (_command[3] & 0x03);
+
+    if (commandPacket.getAck() != 0xA5) {
+        return FAULT::NO_ACK;
+    }
+    if (commandPacket.error) {
+        return FAULT::CRC_ERROR;
+    }
+    if ((commandPacket.getData() & 0x03) != enable) {
+        return FAULT::REGISTER_RESET;
+    }
+
+    if (checkAnalogOutput) {
+        //the line may be driven by another device with the same analog input
+        if (lockAnalogInput(_analogInput, this)) {
+            return FAULT::ANALOG_INPUT_LOCKED;
+        }
+
+        bool error = parkAnalogOutput(ANALOG_OUTPUT::REFERENCE_1_25);
+        delay(2);
+        uint32_t millivolts = analogReadMilliVolts(_analogInput);
+#ifdef LT8722_FAULT_INJECTION
+        millivolts = LT8722FaultInjection::analog(_cs, millivolts);
+#endif
+        error |= releaseAnalogOutput();
+        unlockAnalogInput(_analogInput, this);
+
+        if (error) {
+            return FAULT::NO_ACK;
+        }
+        if (fabs(millivolts / 1000.0 - 1.25) > 0.1) {
+            return FAULT::STUCK_ANALOG_OUTPUT;
+        }
+    }
+
+    return FAULT::NONE;
+}
+
+/**************************************************************************/
+/*!
+    @brief Recover from a fault detected by checkHealth() without a full 
+           softStart(). Communication faults are retried, latched faults 
+           are cleared and the cached command register, limit registers and
+           setpoint are restored with a short ramp from zero. After 
+           emergencyOff() the output stays off until softStart().
+    @param fault Fault returned by checkHealth()
+    @return Error (True) if the fault is still present after the recovery
+*/
+/**************************************************************************/
+bool LT8722::recover(FAULT fault) {
+    uint32_t start = micros();
+    bool checkAnalogOutput = (fault == FAULT::STUCK_ANALOG_OUTPUT || fault == FAULT::ANALOG_INPUT_LOCKED);
+    bool error = false;
+
+    switch (fault) {
+        case FAULT::NONE:
+        case FAULT::NO_ACK:
+        case FAULT::CRC_ERROR:
+        case FAULT::ANALOG_INPUT_LOCKED:
+            //nothing was changed in the device, the check is repeated
+            break;
+        case FAULT::STUCK_ANALOG_OUTPUT:
+            error |= releaseAnalogOutput();
+            break;
+        case FAULT::OVER_CURRENT:
+        case FAULT::OVER_TEMPERATURE:
+        case FAULT::REGISTER_RESET:
+            error |= resetStatusRegister(spi, _cs).error;
+
+            //restore the limits before the output is enabled again
+            for (uint8_t address = 0x02; address <= 0x06; address++) {
+                if (_registerMask & (1 << address)) {
+                    uint8_t data[] = {0x00, 0x00, static_cast<uint8_t>(_registers[address] >> 8), static_cast<uint8_t>(_registers[address])};
+                    error |= writeRegister(spi, _cs, address, data).error;
+                }
+            }
+
+            error |= setOutputVoltageRegister(spi, _cs, 0).error;
+
+            //after an emergency shutdown the output stays off until the next softStart()
+            if (_shutDown) {
+                uint8_t command[4];
+                for (uint8_t i = 0; i < 4; i++) {
+                    command[i] = _command[i];
+                }
+                command[3] &= ~0x03;
+                error |= writeRegister(spi, _cs, 0x00, command).error;
+            } else {
+                error |= writeRegister(spi, _cs, 0x00, _command).error;
+                error |= rampSetpoint(_setpoint);
+            }
+            break;
+    }
+
+    //communication faults are retried a few times before the recovery fails
+    FAULT result = FAULT::NONE;
+    for (uint8_t i = 0; i < LT8722_RECOVERY_RETRIES && !error; i++) {
+        result = checkHealth(checkAnalogOutput);
+        if (result != FAULT::NO_ACK && result != FAULT::CRC_ERROR) {
+            break;
+        }
+    }
+    error |= (result != FAULT::NONE);
+    _recoveryTime = micros() - start;
+
+    return error;
+}
+
+/**************************************************************************/
+/*!
+    @brief Return the duration of the last recovery
+    @return Time in microseconds from the start of recover() until the 
+            device was checked healthy again
+*/
+/**************************************************************************/
+uint32_t LT8722::getRecoveryTime() {
+    return _recoveryTime;
+}
+
+/**************************************************************************/
+/*!
+    @brief Return whether the device was turned off by emergencyOff() 
+           since the last softStart()
+    @return True if the output is latched off
+*/
+/**************************************************************************/
+bool LT8722::isShutDown() {
+    return _shutDown;
+}
+
+/**************************************************************************/
+/*!
+    @brief Probe all given devices with a status read and run a short 
+           self-test (register write/readback and AMUX 1.25V reference
+           check) on every device that answered. The frames are
+           interleaved across the devices and the settling time of the
+           analog output is shared, so the boot time hardly grows with
+           the number of devices. begin() has to be called for every
+           device beforehand. A device whose analog input is locked by
+           another owner is reported as ANALOG_INPUT_LOCKED.
+    @param devices Array of pointers to the devices to be probed
+    @param count Number of devices in the array
+    @param states Output array with the state of every device
+    @return Number of devices that are present and passed the self-test
+*/
+/**************************************************************************/
+uint8_t LT8722::discover(LT8722* devices[], uint8_t count, DEVICE_STATE* states) {
+    uint8_t testPattern[] = {0x00, 0x00, 0x00, 0x0A};   //test pattern for the SPIS_OV_CLAMP register
+    uint8_t clampDefault[] = {0x00, 0x00, 0x00, 0x0F};  //default value of the SPIS_OV_CLAMP register
+    uint8_t amuxReference[] = {0x00, 0x00, 0x00, 0x46}; //AOUT_EN and AMUX 1.25V reference
+    uint8_t amuxDefault[] = {0x00, 0x00, 0x00, 0x00};   //default value of the SPIS_AMUX register
+    uint8_t present = 0;
+
+    //probe every device with a status read
+    for (uint8_t i = 0; i < count; i++) {
+        struct dataSPI dataPacket = readStatus(devices[i]->spi, devices[i]->_cs);
+
+        if (dataPacket.getAck() != 0xA5) {
+            states[i] = DEVICE_STATE::NO_ACK;
+        } else if (dataPacket.error) {
+            states[i] = DEVICE_STATE::CRC_ERROR;
+        } else {
+            states[i] = DEVICE_STATE::PRESENT;
+        }
+    }
+
+    //write the test pattern to all present devices before reading any of them back
+    for (uint8_t i = 0; i < count; i++) {
+        if (states[i] == DEVICE_STATE::PRESENT) {
+            struct dataSPI dataPacket = writeRegister(devices[i]->spi, devices[i]->_cs, 0x05, testPattern);
+
+            if (dataPacket.error) {
+                states[i] = DEVICE_STATE::SELF_TEST_FAILED;
+            }
+        }
+    }
+
+    //read back the test pattern and restore the previous value, the default value if it was never set
+    for (uint8_t i = 0; i < count; i++) {
+        if (states[i] == DEVICE_STATE::PRESENT) {
+            uint8_t *clampRestore = clampDefault;
+            uint8_t clampCached[4];
+            if (devices[i]->_registerMask & (1 << 0x05)) {
+                uint16_t value = devices[i]->_registers[0x05];
+                clampCached[0] = 0x00;
+                clampCached[1] = 0x00;
+                clampCached[2] = static_cast<uint8_t>(value >> 8);
+                clampCached[3] = static_cast<uint8_t>(value);
+                clampRestore = clampCached;
+            }
+
+            struct dataSPI dataPacket0 = readRegister(devices[i]->spi, devices[i]->_cs, 0x05);
+            struct dataSPI dataPacket1 = writeRegister(devices[i]->spi, devices[i]->_cs, 0x05, clampRestore);
+
+            if (!dataPacket1.error) {
+                devices[i]->cacheRegister(0x05, (clampRestore[2] << 8) | clampRestore[3]);
+            }
+
+            if (dataPacket0.error || dataPacket1.error || (dataPacket0.getData() & 0x0F) != testPattern[3]) {
+                states[i] = DEVICE_STATE::SELF_TEST_FAILED;
+            }
+        }
+    }
+
+    //the analog inputs are locked for the reference check, a line driven by another owner is not touched
+    for (uint8_t i = 0; i < count; i++) {
+        if (states[i] == DEVICE_STATE::PRESENT && lockAnalogInput(devices[i]->_analogInput, devices)) {
+            states[i] = DEVICE_STATE::ANALOG_INPUT_LOCKED;
+        }
+    }
+
+    //check the 1.25V reference of the analog outputs, devices sharing an analog input are checked in separate rounds
+    for (uint8_t round = 0; round < count; round++) {
+        bool active = false;
+
+        for (uint8_t i = 0; i < count; i++) {
+            uint8_t rank = 0;
+            for (uint8_t j = 0; j < i; j++) {
+                if (devices[j]->_analogInput == devices[i]->_analogInput) {
+                    rank++;
+                }
+            }
+
+            if (rank == round && states[i] == DEVICE_STATE::PRESENT) {
+                writeRegister(devices[i]->spi, devices[i]->_cs, 0x07, amuxReference);
+                active = true;
+            }
+        }
+
+        if (!active) {
+            continue;
+        }
+
+        delay(2); //shared settling time of all analog outputs in this round
+
+        for (uint8_t i = 0; i < count; i++) {
+            uint8_t rank = 0;
+            for (uint8_t j = 0; j < i; j++) {
+                if (devices[j]->_analogInput == devices[i]->_analogInput) {
+                    rank++;
+                }
+            }
+
+            if (rank == round && states[i] == DEVICE_STATE::PRESENT) {
+                double voltage1P25 = analogReadMilliVolts(devices[i]->_analogInput);
+                voltage1P25 /= 1000;
+                writeRegister(devices[i]->spi, devices[i]->_cs, 0x07, amuxDefault); //the analog output is not cached, it ends disabled as after begin()
+
+                if (fabs(voltage1P25 - 1.25) > 0.1) {
+                    states[i] = DEVICE_STATE::SELF_TEST_FAILED;
+                } else {
+                    present++;
+                }
+            }
+        }
+    }
+
+    for (uint8_t i = 0; i < count; i++) {
+        unlockAnalogInput(devices[i]->_analogInput, devices);
+    }
+
+    return present;
+}
+
+/**************************************************************************/
+/*!
+    @brief Clear ENABLE_REQ and SWEN_REQ of every initialized device by 
+           sending pre-encoded frames. Runs from IRAM, writes the SPI 
+           registers directly and reads nothing back, so it can be 
+           called from an interrupt. The chip select of a running 
+           transfer is released and its hardware transfer is awaited 
+           before the first frame is sent. The devices stay latched off
+           (recover(), wake() and the idle manager keep the output 
+           disabled) until softStart().
+*/
+/**************************************************************************/
+void IRAM_ATTR LT8722::emergencyOff() {
+    int64_t start = esp_timer_get_time();
+    uint32_t reached = 0;
+    _emergencyOffDevices = 0;
+
+    portENTER_CRITICAL_SAFE(&_deviceLock);
+    uint8_t count = _deviceCount;
+
+    //abort any running frame so that no device listens on the bus, then let the hardware finish shifting
+    for (uint8_t i = 0; i < count; i++) {
+        if (_devices[i] != NULL) {
+            deselectChip(_devices[i]->_cs);
+        }
+    }
+    for (uint8_t i = 0; i < count; i++) {
+        if (_devices[i] != NULL) {
+            waitFrameBus(_devices[i]->spi);
+        }
+    }
+
+    for (uint8_t i = 0; i < count; i++) {
+        LT8722* device = _devices[i];
+
+        if (device != NULL) {
+            device->_shutDown = true;               //latched before the frame, nothing enables the output again until softStart()
+        }
+        if (device != NULL && !transferFrameDirect(device->spi, device->_cs, device->_offFrame[device->_offFrameIndex], NULL, 8)) {
+            reached |= (1UL << i);
+            _emergencyOffDevices = reached;
+        }
+    }
+    portEXIT_CRITICAL_SAFE(&_deviceLock);
+
+    _emergencyOffTime = static_cast<uint32_t>(esp_timer_get_time() - start);
+}
+
+/**************************************************************************/
+/*!
+    @brief Attach emergencyOff() to the interrupt of a GPIO pin (e.g. the
+           output of an external supply supervisor). The interrupt is 
+           registered with ESP_INTR_FLAG_IRAM, so it also runs while 
+           the flash cache is disabled. Has to be called before any 
+           attachInterrupt(), unless CONFIG_ARDUINO_ISR_IRAM is set.
+    @param pin GPIO pin that triggers the emergency shutdown
+    @param mode Interrupt mode (FALLING, RISING or CHANGE)
+    @return Error (True) if the mode is not supported or the interrupt
+            could not be registered as IRAM interrupt
+*/
+/**************************************************************************/
+bool LT8722::attachEmergencyOff(uint8_t pin, int mode) {
+    gpio_int_type_t type;
+
+    if (mode == FALLING) {
+        type = GPIO_INTR_NEGEDGE;
+    } else if (mode == RISING) {
+        type = GPIO_INTR_POSEDGE;
+    } else if (mode == CHANGE) {
+        type = GPIO_INTR_ANYEDGE;
+    } else {
+        return true;
+    }
+
+    //attachInterrupt() installs the shared GPIO interrupt without ESP_INTR_FLAG_IRAM, unless CONFIG_ARDUINO_ISR_IRAM is set
+    esp_err_t result = gpio_install_isr_service(ESP_INTR_FLAG_IRAM);
+#ifdef CONFIG_ARDUINO_ISR_IRAM
+    if (result != ESP_OK && result != ESP_ERR_INVALID_STATE) {
+        return true;
+    }
+#else
+    if (result != ESP_OK) {
+        return true;
+    }
+#endif
+
+    bool error = gpio_set_intr_type(static_cast<gpio_num_t>(pin), type) != ESP_OK;
+    error |= gpio_isr_handler_add(static_cast<gpio_num_t>(pin), emergencyOffISR, NULL) != ESP_OK;
+    error |= gpio_intr_enable(static_cast<gpio_num_t>(pin)) != ESP_OK;
+
+    return error;
+}
+
+/**************************************************************************/
+/*!
+    @brief Return the devices reached by the last emergency shutdown
+    @return Bit mask with one bit per device in the order of begin(), 
+            the bit of a destroyed device is reused by the next one
+*/
+/**************************************************************************/
+uint32_t LT8722::getEmergencyOffDevices() {
+    return _emergencyOffDevices;
+}
+
+/**************************************************************************/
+/*!
+    @brief Return the duration of the last emergency shutdown
+    @return Time in microseconds until the outputs of all devices were off
+*/
+/**************************************************************************/
+uint32_t LT8722::getEmergencyOffTime() {
+    return _emergencyOffTime;
+}
+
+/**************************************************************************/
+/*!
+    @brief Interrupt handler of the GPIO pin, forwards to emergencyOff()
+    @param arg Unused
+*/
+/**************************************************************************/
+void IRAM_ATTR LT8722::emergencyOffISR(void *arg) {
+    emergencyOff();
+}
+
+/**************************************************************************/
+/*!
+    @brief Clamp a voltage outside of the limit (not constexpr on purpose,
+           so that it fails the compilation in constant expressions)
+    @param voltage Desired output voltage
+    @param limit Voltage of the limit
+    @return Value of the SPIS_DAC register
+*/
+/**************************************************************************/
+LT8722::VoltageCode LT8722_IRAM_ATTR LT8722::clampVoltageCode(double voltage, double limit) {
+    if (voltage > limit) {
+        voltage = limit;
+    } else if (voltage < -limit) {
+        voltage = -limit;
+    }
+
+    return voltageCode(Volts(voltage));
+}
+
+/**************************************************************************/
+/*!
+    @brief Clamp a current limit outside of the register range (not 
+           constexpr on purpose, so that it fails the compilation in 
+           constant expressions)
+    @param code Unclamped value of the current limit register
+    @return Value of the current limit register
+*/
+/**************************************************************************/
+LT8722::CurrentCode LT8722::clampCurrentCode(double code) {
+    if (code < 0) {
+        return CurrentCode(0);
+    } else if (code > 0x1FF) {
+        return CurrentCode(0x1FF);
+    }
+
+    return CurrentCode(static_cast<uint16_t>(code));
+}
+
+/**************************************************************************/
+/*!
+    @brief Cache the current content of the command register and 
+           pre-encode the frame for the emergency shutdown from it
+    @param command Data of the command register
+*/
+/**************************************************************************/
+void LT8722_IRAM_ATTR LT8722::updateCommand(uint8_t *command) {
+    uint8_t data[4];
+    uint8_t next = _offFrameIndex ^ 0x01;
+
+    for (uint8_t i = 0; i < 4; i++) {
+        _command[i] = command[i];
+        data[i] = command[i];
+    }
+    data[3] &= ~((1 << static_cast<uint8_t>(COMMAND_REG::ENABLE_REQ)) | (1 << static_cast<uint8_t>(COMMAND_REG::SWEN_REQ)));
+
+    //encode into the unused buffer and switch afterwards, so an interrupt never sends a partial frame
+    encodeWriteFrame(0x00, data, _offFrame[next]);
+    _offFrameIndex = next;
+}
+
+/**************************************************************************/
+/*!
+    @brief Track how long the setpoint has been near zero
+    @param code Value of the SPIS_DAC register
+*/
+/**************************************************************************/
+void LT8722_IRAM_ATTR LT8722::trackSetpoint(uint32_t code) {
+    int32_t signedCode = static_cast<int32_t>(code);
+    bool nearZero = (signedCode <= (int32_t)_idleThreshold) && (signedCode >= -(int32_t)_idleThreshold);
+
+    if (nearZero && !_nearZero) {
+        _nearZeroSince = esp_timer_get_time();
+    }
+    _nearZero = nearZero;
+}
+
+/**************************************************************************/
+/*!
+    @brief Restore switching after idle and ramp to the new setpoint
+    @param code Value of the SPIS_DAC register
+    @return Error (True) if an error accrued during the SPI communication
+            or the output is latched off by emergencyOff()
+*/
+/**************************************************************************/
+bool LT8722_IRAM_ATTR LT8722::wake(uint32_t code) {
+    int64_t start = esp_timer_get_time();
+    uint8_t data[4];
+    bool error = false;
+
+    //an emergency shutdown is only released by softStart()
+    if (_shutDown) {
+        return true;
+    }
+
+    //set SWEN_REQ with a single write of the cached command register instead of a read-modify-write
+    for (uint8_t i = 0; i < 4; i++) {
+        data[i] = _command[i];
+    }
+    data[3] |= (1 << static_cast<uint8_t>(COMMAND_REG::SWEN_REQ));
+
+    struct dataSPI dataPacket = writeRegister(spi, _cs, 0x00, data);
+    if (dataPacket.error) {
+        return true;
+    }
+    updateCommand(data);
+
+    _idle = false;
+    _idleTime += esp_timer_get_time() - _idleStart;
+
+    error |= rampSetpoint(code);
+
+    trackSetpoint(code);
+    _wakeLatency = static_cast<uint32_t>(esp_timer_get_time() - start);
+
+    return error;
+}
+
+/**************************************************************************/
+/*!
+    @brief Ramp the output in LT8722_WAKE_STEPS steps from zero to the 
+           given setpoint
+    @param code Value of the SPIS_DAC register
+    @return Error (True) if an error accrued during the SPI communication
+*/
+/**************************************************************************/
+bool LT8722_IRAM_ATTR LT8722::rampSetpoint(uint32_t code) {
+    int32_t signedCode = static_cast<int32_t>(code);
+    int32_t step = signedCode / LT8722_WAKE_STEPS;
+    int32_t remainder = signedCode % LT8722_WAKE_STEPS;
+    bool error = false;
+
+    //code * i / LT8722_WAKE_STEPS split into quotient and remainder, without a 64-bit division in IRAM
+    for (int32_t i = 1; i <= LT8722_WAKE_STEPS; i++) {
+        int32_t stepCode = step * i + remainder * i / LT8722_WAKE_STEPS;
+        error |= setOutputVoltageRegister(spi, _cs, static_cast<uint32_t>(stepCode)).error;
+        if (i < LT8722_WAKE_STEPS) {
+            esp_rom_delay_us(LT8722_WAKE_STEP_US);
+        }
+    }
+
+    return error;
+}
+
+/**************************************************************************/
+/*!
+    @brief Remember the value written to a limit register, so that it can
+           be restored after a fault
+    @param address Address of the register (0x02 - 0x06)
+    @param value Value written to the register
+*/
+/**************************************************************************/
+void LT8722::cacheRegister(uint8_t address, uint16_t value) {
+    _registers[address] = value;
+    _registerMask |= (1 << address);
+}
@@ -16,6 +16,30 @@
 #include <Arduino.h>
 #include <SPI.h>
 
+#ifndef LT8722_MAX_DEVICES
+#define LT8722_MAX_DEVICES 32   //maximum number of devices reached by the emergency shutdown
+#endif
+
+static_assert(LT8722_MAX_DEVICES <= 32, "the devices reached by the emergency shutdown are reported in a 32 bit mask");
+
+#ifndef LT8722_WAKE_STEPS
+#define LT8722_WAKE_STEPS 8      //number of steps of the warm ramp after idle
+#endif
+
+#ifndef LT8722_WAKE_STEP_US
+#define LT8722_WAKE_STEP_US 100  //duration of one step of the warm ramp in microseconds
+#endif
+
+#ifndef LT8722_ANALOG_INPUTS
+#define LT8722_ANALOG_INPUTS 64  //number of GPIOs that can be locked as analog input
+#endif
+
+#define LT8722_MIN_CURRENT 14     //smallest output current in mA of the current mode (SPIS_ILIMP = 0x1FF)
+
+#ifndef LT8722_RECOVERY_RETRIES
+#define LT8722_RECOVERY_RETRIES 3 //checks after a recovery before a communication fault counts as persistent
+#endif
+
 enum class VOLTAGE_LIMIT : uint8_t{
     LIMIT_1_25  = 0x00,
     LIMIT_2_50  = 0x01,
@@ -80,13 +104,149 @@ enum class POWER_LIMIT : uint8_t{
 };
 
 enum class ANALOG_OUTPUT : uint8_t{
-    VOLTAGE     = 0x03,
-    CURRENT     = 0x04,
-    TEMPERATURE = 0x08
+    VOLTAGE        = 0x03,
+    CURRENT        = 0x04,
+    REFERENCE_1_25 = 0x06,
+    REFERENCE_1_65 = 0x07,
+    TEMPERATURE    = 0x08
+};
+
+enum class DEVICE_STATE : uint8_t{
+    PRESENT             = 0x00,
+    NO_ACK              = 0x01,
+    CRC_ERROR           = 0x02,
+    SELF_TEST_FAILED    = 0x03,
+    ANALOG_INPUT_LOCKED = 0x04
+};
+
+enum class FAULT : uint8_t{
+    NONE                = 0x00,
+    NO_ACK              = 0x01,
+    CRC_ERROR           = 0x02,
+    OVER_CURRENT        = 0x03,
+    OVER_TEMPERATURE    = 0x04,
+    REGISTER_RESET      = 0x05,
+    STUCK_ANALOG_OUTPUT = 0x06,
+    ANALOG_INPUT_LOCKED = 0x07
 };
 
 class LT8722 {
 public:
+    //units and register codes for setpoints that are known at compile time
+
+    struct Volts {
+        constexpr explicit Volts(double voltage) : value(voltage) {}
+        constexpr Volts operator-() const { return Volts(-value); }
+        double value;
+    };
+
+    struct Amps {
+        constexpr explicit Amps(double current) : value(current) {}
+        double value;
+    };
+
+    struct VoltageCode {
+        constexpr explicit VoltageCode(uint32_t code = 0) : value(code) {}
+        uint32_t value;
+    };
+
+    struct CurrentCode {
+        constexpr explicit CurrentCode(uint16_t code = 0) : value(code) {}
+        uint16_t value;
+    };
+
+    /**************************************************************************/
+    /*!
+        @brief Convert an output voltage to the value of the SPIS_DAC register.
+               Used in a constant expression (e.g. constexpr variable), a 
+               voltage outside of the given limit is a compile error. At 
+               runtime such a voltage is clamped to the limit.
+        @param voltage Desired output voltage
+        @param limit Voltage limit the voltage has to be within
+        @return Value of the SPIS_DAC register
+    */
+    /**************************************************************************/
+    static constexpr VoltageCode voltageCode(Volts voltage, VOLTAGE_LIMIT limit = VOLTAGE_LIMIT::LIMIT_20_00) {
+        return (voltage.value <= limitVoltage(limit) && voltage.value >= -limitVoltage(limit))
+            ? VoltageCode(static_cast<uint32_t>(static_cast<int32_t>(voltage.value * 838860.8))) //2^25 / (2.5 * 16)
+            : clampVoltageCode(voltage.value, limitVoltage(limit));
+    }
+
+    /**************************************************************************/
+    /*!
+        @brief Convert a positive current limit to the value of the SPIS_ILIMP
+               register. Used in a constant expression, a current outside of 
+               the register range is a compile error. At runtime such a 
+               current is clamped to the register range.
+        @param current Positive current limit
+        @return Value of the SPIS_ILIMP register
+    */
+    /**************************************************************************/
+    static constexpr CurrentCode positiveCurrentCode(Amps current) {
+        return (current.value <= 6.8 && (6.8 - current.value) / 0.01328 < 512)
+            ? CurrentCode(static_cast<uint16_t>((6.8 - current.value) / 0.01328))
+            : clampCurrentCode((6.8 - current.value) / 0.01328);
+    }
+
+    /**************************************************************************/
+    /*!
+        @brief Convert a negative current limit to the value of the SPIS_ILIMN
+               register. Used in a constant expression, a current outside of 
+               the register range is a compile error. At runtime such a 
+               current is clamped to the register range.
+        @param current Negative current limit (magnitude)
+        @return Value of the SPIS_ILIMN register
+    */
+    /**************************************************************************/
+    static constexpr CurrentCode negativeCurrentCode(Amps current) {
+        return (current.value >= 0 && current.value / 0.01328 < 512)
+            ? CurrentCode(static_cast<uint16_t>(current.value / 0.01328))
+            : clampCurrentCode(current.value / 0.01328);
+    }
+
+    /**************************************************************************/
+    /*!
+        @brief Convert a positive current limit in milliamperes to the value
+               of the SPIS_ILIMP register with integer arithmetic only, a 
+               current outside of the register range is clamped
+        @param milliamps Positive current limit in mA
+        @return Value of the SPIS_ILIMP register
+    */
+    /**************************************************************************/
+    static constexpr CurrentCode positiveCurrentCodeMilliamps(int32_t milliamps) {
+        return CurrentCode(static_cast<uint16_t>(
+            (milliamps >= 6800) ? 0 :
+            (milliamps <= 14) ? 0x1FF :
+            (6800 - milliamps) * 1000 / 13280));            //(6.8A - I) / 13.28mA
+    }
+
+    /**************************************************************************/
+    /*!
+        @brief Convert a negative current limit (magnitude) in milliamperes to
+               the value of the SPIS_ILIMN register with integer arithmetic 
+               only, a current outside of the register range is clamped
+        @param milliamps Negative current limit in mA (magnitude)
+        @return Value of the SPIS_ILIMN register
+    */
+    /**************************************************************************/
+    static constexpr CurrentCode negativeCurrentCodeMilliamps(int32_t milliamps) {
+        return CurrentCode(static_cast<uint16_t>(
+            (milliamps <= 0) ? 0 :
+            (milliamps >= 6786) ? 0x1FF :
+            milliamps * 1000 / 13280));                     //I / 13.28mA
+    }
+
+    /**************************************************************************/
+    /*!
+        @brief Return the voltage of a predefined voltage limit
+        @param limit Predefined voltage limit
+        @return Voltage of the limit
+    */
+    /**************************************************************************/
+    static constexpr double limitVoltage(VOLTAGE_LIMIT limit) {
+        return (static_cast<uint8_t>(limit) + 1) * 1.25;
+    }
+
     //constructor and begin function
 
     /**************************************************************************/
@@ -99,14 +259,25 @@ public:
 
     /**************************************************************************/
     /*!
-        @brief Initialize the SPI interface
+        @brief Remove the LT8722 object from the emergency shutdown
+    */
+    /**************************************************************************/
+    ~LT8722();
+
+    /**************************************************************************/
+    /*!
+        @brief Initialize the SPI interface and register the device for the 
+               emergency shutdown
         @param miso the SPI MISO pin to use
         @param mosi the SPI MOSI pin to use
         @param sck the SPI clock pin to use
         @param cs the SPI CS pin to use
+        @return Error (True) if an error accrued during the SPI communication
+                or the device could not be registered for the emergency 
+                shutdown (more than LT8722_MAX_DEVICES devices)
     */
     /**************************************************************************/
-    void begin(uint8_t miso = 13, uint8_t mosi = 11, uint8_t sck = 12, uint8_t cs = 10, uint8_t analogInput = 8);
+    bool begin(uint8_t miso = 13, uint8_t mosi = 11, uint8_t sck = 12, uint8_t cs = 10, uint8_t analogInput = 8);
 
     //important control functions
 
@@ -144,6 +315,32 @@ public:
     /**************************************************************************/
     bool setVoltage(double voltage);
 
+    /**************************************************************************/
+    /*!
+        @brief Set the output voltage with a precalculated register value.
+               With LT8722_USE_IRAM the whole path runs from IRAM, so it can
+               be called from an IRAM interrupt during flash writes.
+        @param code Register value from voltageCode()
+        @return Error (True) if an error accrued during the SPI communication
+    */
+    /**************************************************************************/
+    bool setVoltage(VoltageCode code);
+
+    /**************************************************************************/
+    /*!
+        @brief Set the output voltage with a write frame of the SPIS_DAC 
+               register that was already encoded with encodeWriteFrame(), so
+               no calculation is left at the time the frame is sent
+        @param frame Encoded write frame with a length of eight bytes
+        @param code Register value contained in the frame
+        @param start Output, time right before the chip select goes low in
+               microseconds (esp_timer_get_time()), NULL if not needed
+        @return Error (True) if the frame was not acknowledged or the CRC of
+                the answer is wrong
+    */
+    /**************************************************************************/
+    bool setVoltageFrame(const uint8_t *frame, uint32_t code, int64_t *start = NULL);
+
     //functions for validating the correct functionality
 
     /**************************************************************************/
@@ -191,6 +388,16 @@ public:
     /**************************************************************************/
     bool setPositiveCurrentLimit(double limit);
 
+    /**************************************************************************/
+    /*!
+        @brief Define the maximum positive current limit with a precalculated 
+               register value
+        @param code Register value from positiveCurrentCode()
+        @return Error (True) if an error accrued during the SPI communication
+    */
+    /**************************************************************************/
+    bool setPositiveCurrentLimit(CurrentCode code);
+
     /**************************************************************************/
     /*!
         @brief Define the maximum negative current limit
@@ -200,6 +407,16 @@ public:
     /**************************************************************************/
     bool setNegativeCurrentLimit(double limit);
 
+    /**************************************************************************/
+    /*!
+        @brief Define the maximum negative current limit with a precalculated 
+               register value
+        @param code Register value from negativeCurrentCode()
+        @return Error (True) if an error accrued during the SPI communication
+    */
+    /**************************************************************************/
+    bool setNegativeCurrentLimit(CurrentCode code);
+
     //additional control functions
 
     /**************************************************************************/
@@ -262,15 +479,418 @@ public:
     /*!
         @brief Read the selected value of the analog output pin
         @param value Predefined value to be read
-        @return value of the selected analog output
+        @return value of the selected analog output, NAN if the analog 
+                input is locked by another device or a LT8722SharedOutput
     */
     /**************************************************************************/
     double readAnalogOutput(ANALOG_OUTPUT value);
 
+    /**************************************************************************/
+    /*!
+        @brief Enable the analog output and keep it on the selected value, 
+               e.g. for a continuous capture of the analog output pin
+        @param value Predefined value to be selected
+        @return Error (True) if an error accrued during the SPI communication
+    */
+    /**************************************************************************/
+    bool parkAnalogOutput(ANALOG_OUTPUT value);
+
+    /**************************************************************************/
+    /*!
+        @brief Disable the analog output after parkAnalogOutput()
+        @return Error (True) if an error accrued during the SPI communication
+    */
+    /**************************************************************************/
+    bool releaseAnalogOutput();
+
+    /**************************************************************************/
+    /*!
+        @brief Select a value of the AMUX while the analog output stays 
+               disabled (high impedance), e.g. to prepare a device on a 
+               shared analog output line
+        @param value Predefined value to be selected
+        @return Error (True) if an error accrued during the SPI communication
+    */
+    /**************************************************************************/
+    bool selectAnalogOutput(ANALOG_OUTPUT value);
+
+    /**************************************************************************/
+    /*!
+        @brief Return the pin connected to the analog output of the LT8722
+        @return Analog input pin given to begin()
+    */
+    /**************************************************************************/
+    uint8_t getAnalogInput();
+
+    /**************************************************************************/
+    /*!
+        @brief Lock an analog input pin, so that only one owner drives the
+               analog output line connected to it (e.g. readAnalogOutput()
+               or a LT8722SharedOutput)
+        @param pin Analog input pin
+        @param owner Object that takes the lock
+        @return Error (True) if the pin is locked by another owner
+    */
+    /**************************************************************************/
+    static bool lockAnalogInput(uint8_t pin, const void *owner);
+
+    /**************************************************************************/
+    /*!
+        @brief Unlock an analog input pin locked by lockAnalogInput()
+        @param pin Analog input pin
+        @param owner Object that took the lock
+    */
+    /**************************************************************************/
+    static void unlockAnalogInput(uint8_t pin, const void *owner);
+
+    /**************************************************************************/
+    /*!
+        @brief Convert the voltage of the analog output pin to the selected
+               value, as done by readAnalogOutput()
+        @param value Predefined value of the analog output
+        @param voltage Voltage of the analog output pin in volts
+        @param reference Voltage of the 1.25V (VOLTAGE) or 1.65V (CURRENT)
+               reference in volts, not used for TEMPERATURE
+        @return Converted value of the selected analog output
+    */
+    /**************************************************************************/
+    static double convertAnalogOutput(ANALOG_OUTPUT value, double voltage, double reference);
+
+    //current-mode control
+
+    /**************************************************************************/
+    /*!
+        @brief Switch to current-mode control: the voltage limits are set to
+               the compliance voltage and the output current is regulated by 
+               the current limiter of the LT8722 with setCurrent()
+        @param compliance Predefined voltage limit used as compliance voltage
+        @return Error (True) if an error accrued during the SPI communication
+    */
+    /**************************************************************************/
+    bool enableCurrentMode(VOLTAGE_LIMIT compliance);
+
+    /**************************************************************************/
+    /*!
+        @brief Set the output current in current mode. The output voltage is
+               driven to the compliance voltage in the direction of the 
+               current and the current limit register of this direction 
+               holds the setpoint, so an update within one direction is a 
+               single frame. A change of direction first reduces the other 
+               current limit to its minimum. The smallest current limit is 
+               LT8722_MIN_CURRENT, so a current below it in both directions
+               sets the output to 0V instead.
+        @param milliamps Output current in mA (negative for reverse current)
+        @return Error (True) if an error accrued during the SPI communication
+                or the current mode is not enabled
+    */
+    /**************************************************************************/
+    bool setCurrent(int32_t milliamps);
+
+    /**************************************************************************/
+    /*!
+        @brief Leave the current mode: the output voltage is set to 0V and 
+               both current limits to their maximum
+        @return Error (True) if an error accrued during the SPI communication
+    */
+    /**************************************************************************/
+    bool disableCurrentMode();
+
+    //automatic low-power idle
+
+    /**************************************************************************/
+    /*!
+        @brief Configure the idle manager. If the setpoint stays near zero 
+               for the given time, switching is stopped (SWEN_REQ cleared).
+               The next setpoint restores switching with a short warm ramp
+               from the cached register state instead of a softstart.
+        @param timeout Time in milliseconds near zero before idle (0 = off)
+        @param threshold Setpoints up to this voltage count as near zero
+        @return Error (True) if switching could not be restored when the idle
+                manager is turned off while idle, the settings are kept then
+    */
+    /**************************************************************************/
+    bool setIdle(uint32_t timeout, double threshold = 0.01);
+
+    /**************************************************************************/
+    /*!
+        @brief Enter idle if the setpoint has been near zero long enough, has
+               to be called regularly (e.g. in the loop)
+        @return Error (True) if an error accrued during the SPI communication
+    */
+    /**************************************************************************/
+    bool updateIdle();
+
+    /**************************************************************************/
+    /*!
+        @brief Return whether switching is currently stopped by the idle 
+               manager
+        @return True if the device is idle
+    */
+    /**************************************************************************/
+    bool isIdle();
+
+    /**************************************************************************/
+    /*!
+        @brief Return the total time spent in idle, which is the time the 
+               switching losses were saved
+        @return Idle time in milliseconds
+    */
+    /**************************************************************************/
+    uint32_t getIdleTime();
+
+    /**************************************************************************/
+    /*!
+        @brief Return the duration of the last wake-up from idle
+        @return Time in microseconds from the setpoint call until the new 
+                setpoint was reached
+    */
+    /**************************************************************************/
+    uint32_t getWakeLatency();
+
+    //fault detection and recovery
+
+    /**************************************************************************/
+    /*!
+        @brief Check the device for faults: communication (acknowledge and 
+               CRC), latched overcurrent or thermal shutdown in the status
+               register, a command register that no longer matches the state
+               set by the library (both enable bits cleared after 
+               emergencyOff()) and optionally a stuck analog output
+        @param checkAnalogOutput Also check the 1.25V reference on the analog 
+               output (takes about 2ms), ANALOG_INPUT_LOCKED is returned 
+               if another owner holds the analog input
+        @return Detected fault, NONE if the device is healthy
+    */
+    /**************************************************************************/
+    FAULT checkHealth(bool checkAnalogOutput = false);
+
+    /**************************************************************************/
+    /*!
+        @brief Recover from a fault detected by checkHealth() without a full 
+               softStart(). Communication faults are retried, latched faults 
+               are cleared and the cached command register, limit registers and
+               setpoint are restored with a short ramp from zero. After 
+               emergencyOff() the output stays off until softStart().
+        @param fault Fault returned by checkHealth()
+        @return Error (True) if the fault is still present after the recovery
+    */
+    /**************************************************************************/
+    bool recover(FAULT fault);
+
+    /**************************************************************************/
+    /*!
+        @brief Return the duration of the last recovery
+        @return Time in microseconds from the start of recover() until the 
+                device was checked healthy again
+    */
+    /**************************************************************************/
+    uint32_t getRecoveryTime();
+
+    /**************************************************************************/
+    /*!
+        @brief Return whether the device was turned off by emergencyOff() 
+               since the last softStart()
+        @return True if the output is latched off
+    */
+    /**************************************************************************/
+    bool isShutDown();
+
+    //discovery and self-test of multiple devices
+
+    /**************************************************************************/
+    /*!
+        @brief Probe all given devices with a status read and run a short 
+               self-test (register write/readback and AMUX 1.25V reference
+               check) on every device that answered. The frames are
+               interleaved across the devices and the settling time of the
+               analog output is shared, so the boot time hardly grows with
+               the number of devices. begin() has to be called for every
+               device beforehand. A device whose analog input is locked by
+               another owner is reported as ANALOG_INPUT_LOCKED.
+        @param devices Array of pointers to the devices to be probed
+        @param count Number of devices in the array
+        @param states Output array with the state of every device
+        @return Number of devices that are present and passed the self-test
+    */
+    /**************************************************************************/
+    static uint8_t discover(LT8722* devices[], uint8_t count, DEVICE_STATE* states);
+
+    //emergency shutdown of all devices
+
+    /**************************************************************************/
+    /*!
+        @brief Clear ENABLE_REQ and SWEN_REQ of every initialized device by 
+               sending pre-encoded frames. Runs from IRAM, writes the SPI 
+               registers directly and reads nothing back, so it can be 
+               called from an interrupt. The chip select of a running 
+               transfer is released and its hardware transfer is awaited 
+               before the first frame is sent. The devices stay latched off
+               (recover(), wake() and the idle manager keep the output 
+               disabled) until softStart().
+    */
+    /**************************************************************************/
+    static void emergencyOff();
+
+    /**************************************************************************/
+    /*!
+        @brief Attach emergencyOff() to the interrupt of a GPIO pin (e.g. the
+               output of an external supply supervisor). The interrupt is 
+               registered with ESP_INTR_FLAG_IRAM, so it also runs while 
+               the flash cache is disabled. Has to be called before any 
+               attachInterrupt(), unless CONFIG_ARDUINO_ISR_IRAM is set.
+        @param pin GPIO pin that triggers the emergency shutdown
+        @param mode Interrupt mode (FALLING, RISING or CHANGE)
+        @return Error (True) if the mode is not supported or the interrupt
+                could not be registered as IRAM interrupt
+    */
+    /**************************************************************************/
+    static bool attachEmergencyOff(uint8_t pin, int mode = FALLING);
+
+    /**************************************************************************/
+    /*!
+        @brief Return the devices reached by the last emergency shutdown
+        @return Bit mask with one bit per device in the order of begin(), 
+                the bit of a destroyed device is reused by the next one
+    */
+    /**************************************************************************/
+    static uint32_t getEmergencyOffDevices();
+
+    /**************************************************************************/
+    /*!
+        @brief Return the duration of the last emergency shutdown
+        @return Time in microseconds until the outputs of all devices were off
+    */
+    /**************************************************************************/
+    static uint32_t getEmergencyOffTime();
+
 private:
+    /**************************************************************************/
+    /*!
+        @brief Interrupt handler of the GPIO pin, forwards to emergencyOff()
+        @param arg Unused
+    */
+    /**************************************************************************/
+    static void emergencyOffISR(void *arg);
+
+    /**************************************************************************/
+    /*!
+        @brief Clamp a voltage outside of the limit (not constexpr on purpose,
+               so that it fails the compilation in constant expressions)
+        @param voltage Desired output voltage
+        @param limit Voltage of the limit
+        @return Value of the SPIS_DAC register
+    */
+    /**************************************************************************/
+    static VoltageCode clampVoltageCode(double voltage, double limit);
+
+    /**************************************************************************/
+    /*!
+        @brief Clamp a current limit outside of the register range (not 
+               constexpr on purpose, so that it fails the compilation in 
+               constant expressions)
+        @param code Unclamped value of the current limit register
+        @return Value of the current limit register
+    */
+    /**************************************************************************/
+    static CurrentCode clampCurrentCode(double code);
+
+    /**************************************************************************/
+    /*!
+        @brief Cache the current content of the command register and 
+               pre-encode the frame for the emergency shutdown from it
+        @param command Data of the command register
+    */
+    /**************************************************************************/
+    void updateCommand(uint8_t *command);
+
+    /**************************************************************************/
+    /*!
+        @brief Track how long the setpoint has been near zero
+        @param code Value of the SPIS_DAC register
+    */
+    /**************************************************************************/
+    void trackSetpoint(uint32_t code);
+
+    /**************************************************************************/
+    /*!
+        @brief Restore switching after idle and ramp to the new setpoint
+        @param code Value of the SPIS_DAC register
+        @return Error (True) if an error accrued during the SPI communication
+                or the output is latched off by emergencyOff()
+    */
+    /**************************************************************************/
+    bool wake(uint32_t code);
+
+    /**************************************************************************/
+    /*!
+        @brief Ramp the output in LT8722_WAKE_STEPS steps from zero to the 
+               given setpoint
+        @param code Value of the SPIS_DAC register
+        @return Error (True) if an error accrued during the SPI communication
+    */
+    /**************************************************************************/
+    bool rampSetpoint(uint32_t code);
+
+    /**************************************************************************/
+    /*!
+        @brief Remember the value written to a limit register, so that it can
+               be restored after a fault
+        @param address Address of the register (0x02 - 0x06)
+        @param value Value written to the register
+    */
+    /**************************************************************************/
+    void cacheRegister(uint8_t address, uint16_t value);
+
     SPIClass* spi;
+    uint8_t _spiBus;
     uint8_t _cs;
     uint8_t _analogInput;
+    uint8_t _command[4];
+    uint8_t _offFrame[2][8];
+    volatile uint8_t _offFrameIndex;
+
+    uint32_t _idleTimeout;
+    uint32_t _idleThreshold;
+    int64_t _nearZeroSince;                 //times in microseconds (esp_timer_get_time())
+    int64_t _idleStart;
+    int64_t _idleTime;
+    uint32_t _wakeLatency;
+    bool _nearZero;
+    bool _idle;
+    volatile bool _shutDown;                //set by emergencyOff(), cleared by softStart()
+
+    uint32_t _setpoint;
+    VOLTAGE_LIMIT _compliance;
+    int8_t _currentDirection;
+    bool _currentMode;
+    uint16_t _registers[7];
+    uint8_t _registerMask;
+    uint32_t _recoveryTime;
+
+    static LT8722* _devices[LT8722_MAX_DEVICES];
+    static uint8_t _deviceCount;
+    static portMUX_TYPE _deviceLock;
+    static volatile uint32_t _emergencyOffDevices;
+    static volatile uint32_t _emergencyOffTime;
+    static const void* _analogInputOwners[LT8722_ANALOG_INPUTS];
 };
 
+//user-defined literals for setpoints (e.g. 2.5_V and 1.2_A)
+
+constexpr LT8722::Volts operator"" _V(long double voltage) {
+    return LT8722::Volts(static_cast<double>(voltage));
+}
+
+constexpr LT8722::Volts operator"" _V(unsigned long long voltage) {
+    return LT8722::Volts(static_cast<double>(voltage));
+}
+
+constexpr LT8722::Amps operator"" _A(long double current) {
+    return LT8722::Amps(static_cast<double>(current));
+}
+
+constexpr LT8722::Amps operator"" _A(unsigned long long current) {
+    return LT8722::Amps(static_cast<double>(current));
+}
+
 #endif
\ No newline at end of file
@@ -0,0 +1,218 @@
+/*
+ * File Name: LT8722Bitstream.cpp
+ * Description: Encoding of complete LT8722 frames into a parallel bit 
+ *              stream for the I2S/LCD peripheral. Every 8-bit sample holds
+ *              one level of SCK (bit 0), MOSI (bit 1) and up to six chip
+ *              select lanes (bits 2 to 7). One SPI bit takes two samples 
+ *              (SCK low and high), the chip select setup, hold and the gap
+ *              between the frames are part of the stream. A decoder checks
+ *              the timing of a stream and recovers the frames, so the 
+ *              generation can be verified without hardware. Does not depend
+ *              on the Arduino core or ESP-IDF, so it is also checked on the
+ *              host.
+ *
+ * Notes: This code was written as part of my master's thesis at the
+ *        Institute for Microsensors, -actuators and -systems (IMSAS)
+ *        at the University of Bremen.
+ */
+
+#include "LT8722Bitstream.h"
+
+/**************************************************************************/
+/*!
+    @brief Create the encoder
+    @param timing Chip select setup, hold and gap in samples
+*/
+/**************************************************************************/
+LT8722Bitstream::LT8722Bitstream(LT8722BitstreamTiming timing) {
+    _timing = timing;
+}
+
+/**************************************************************************/
+/*!
+    @brief Return the number of samples of one encoded frame
+    @param length Number of bytes of the frame
+    @return Number of samples including setup, hold and gap
+*/
+/**************************************************************************/
+uint32_t LT8722Bitstream::getFrameSamples(uint8_t length) {
+    return _timing.setup + 16 * length + _timing.hold + _timing.gap;
+}
+
+/**************************************************************************/
+/*!
+    @brief Encode a complete frame for one chip select lane
+    @param lane Chip select lane (0 - 5)
+    @param frame Bytes of the frame, MSB first
+    @param length Number of bytes
+    @param output Output array for the samples
+    @param capacity Number of samples that fit into the output array
+    @return Number of samples written, 0 if the frame does not fit
+*/
+/**************************************************************************/
+uint32_t LT8722Bitstream::encodeFrame(uint8_t lane, const uint8_t *frame, uint8_t length, uint8_t *output, uint32_t capacity) {
+    uint32_t samples = getFrameSamples(length);
+
+    if (lane >= LT8722_BITSTREAM_MAX_LANES || samples > capacity) {
+        return 0;
+    }
+
+    uint8_t selected = LT8722_BITSTREAM_IDLE & ~(1 << (lane + LT8722_BITSTREAM_CS_SHIFT));
+    uint32_t index = 0;
+
+    for (uint8_t i = 0; i < _timing.setup; i++) {
+        output[index++] = selected;
+    }
+
+    //SPI mode 0: MOSI changes while SCK is low and is sampled on the rising edge
+    for (uint8_t i = 0; i < length; i++) {
+        for (int8_t bit = 7; bit >= 0; bit--) {
+            uint8_t level = selected | (((frame[i] >> bit) & 0x01) ? LT8722_BITSTREAM_MOSI : 0x00);
+            output[index++] = level;
+            output[index++] = level | LT8722_BITSTREAM_SCK;
+        }
+    }
+
+    for (uint8_t i = 0; i < _timing.hold; i++) {
+        output[index++] = selected;
+    }
+
+    for (uint16_t i = 0; i < _timing.gap; i++) {
+        output[index++] = LT8722_BITSTREAM_IDLE;
+    }
+
+    return index;
+}
+
+/**************************************************************************/
+/*!
+    @brief Encode a write frame of the SPIS_DAC register (setpoint)
+    @param lane Chip select lane (0 - 5)
+    @param code Register value, e.g. from LT8722::voltageCode()
+    @param output Output array for the samples
+    @param capacity Number of samples that fit into the output array
+    @return Number of samples written, 0 if the frame does not fit
+*/
+/**************************************************************************/
+uint32_t LT8722Bitstream::encodeSetpoint(uint8_t lane, uint32_t code, uint8_t *output, uint32_t capacity) {
+    uint8_t data[] = {static_cast<uint8_t>(code >> 24), static_cast<uint8_t>(code >> 16), static_cast<uint8_t>(code >> 8), static_cast<uint8_t>(code)};
+    uint8_t frame[8];
+
+    encodeWriteFrame(0x04, data, frame);
+
+    return encodeFrame(lane, frame, 8, output, capacity);
+}
+
+/**************************************************************************/
+/*!
+    @brief Fill samples with the idle state (all chip selects high)
+    @param output Output array for the samples
+    @param count Number of samples
+    @return Number of samples written
+*/
+/**************************************************************************/
+uint32_t LT8722Bitstream::encodeIdle(uint8_t *output, uint32_t count) {
+    memset(output, LT8722_BITSTREAM_IDLE, count);
+    return count;
+}
+
+/**************************************************************************/
+/*!
+    @brief Recover the frames of a stream and check its timing: only one 
+           chip select low at a time, MOSI and chip selects stable while
+           SCK is high, setup, hold and gap at least as configured and 
+           whole bytes in every frame
+    @param samples Samples of the stream, starting in the idle state
+    @param count Number of samples
+    @param frames Output array for the decoded frames
+    @param maxFrames Number of frames that fit into the output array
+    @param violations Output for the number of timing violations
+    @return Number of decoded frames
+*/
+/**************************************************************************/
+uint32_t LT8722Bitstream::decode(const uint8_t *samples, uint32_t count, LT8722BitstreamFrame *frames, uint32_t maxFrames, uint32_t *violations) {
+    uint8_t previous = LT8722_BITSTREAM_IDLE;
+    uint32_t decoded = 0;
+    uint32_t errors = 0;
+    uint32_t frameEnd = 0;
+    uint32_t firstRise = 0;
+    uint32_t lastRise = 0;
+    uint32_t bits = 0;
+    bool active = false;
+    bool first = true;
+    LT8722BitstreamFrame frame = {};
+
+    for (uint32_t i = 0; i < count; i++) {
+        uint8_t sample = samples[i];
+        uint8_t selects = ~sample & LT8722_BITSTREAM_IDLE;
+
+        //at most one chip select may be low
+        if (selects & (selects - 1)) {
+            errors++;
+        }
+
+        //MOSI and the chip selects must not change with the rising edge or while SCK is high
+        if ((sample & LT8722_BITSTREAM_SCK) && ((previous ^ sample) & ~LT8722_BITSTREAM_SCK)) {
+            errors++;
+        }
+
+        if (!active && selects != 0) {
+            //start of a frame, the gap since the last frame is checked
+            if (!first && i - frameEnd < _timing.gap) {
+                errors++;
+            }
+            active = true;
+            bits = 0;
+            frame = {};
+            frame.start = i;
+            while (!(selects & (1 << (frame.lane + LT8722_BITSTREAM_CS_SHIFT)))) {
+                frame.lane++;
+            }
+        } else if (active && selects == 0) {
+            //end of a frame
+            active = false;
+            first = false;
+            frameEnd = i;
+
+            if (bits % 8 != 0 || bits == 0 || i - lastRise - 1 < _timing.hold) {
+                errors++;
+            } else if (decoded < maxFrames) {
+                frame.length = bits / 8;
+                frames[decoded] = frame;
+                decoded++;
+            }
+        }
+
+        //rising edge of SCK: MOSI is sampled
+        if (!(previous & LT8722_BITSTREAM_SCK) && (sample & LT8722_BITSTREAM_SCK)) {
+            if (!active) {
+                errors++;
+            } else {
+                if (bits == 0) {
+                    firstRise = i;
+                    if ((int32_t)(firstRise - frame.start) - 1 < _timing.setup) {
+                        errors++;
+                    }
+                }
+                if (bits < 64) {
+                    frame.data[bits / 8] = (frame.data[bits / 8] << 1) | ((sample & LT8722_BITSTREAM_MOSI) ? 1 : 0);
+                }
+                bits++;
+                lastRise = i;
+            }
+        }
+
+        previous = sample;
+    }
+
+    //a frame that is still open at the end of the stream
+    if (active) {
+        errors++;
+    }
+
+    if (violations != NULL) {
+        *violations = errors;
+    }
+
+    return decoded;
+}
@@ -0,0 +1,119 @@
+/*
+ * File Name: LT8722Bitstream.h
+ * Description: Encoding of complete LT8722 frames into a parallel bit 
+ *              stream for the I2S/LCD peripheral. Every 8-bit sample holds
+ *              one level of SCK (bit 0), MOSI (bit 1) and up to six chip
+ *              select lanes (bits 2 to 7). One SPI bit takes two samples 
+ *              (SCK low and high), the chip select setup, hold and the gap
+ *              between the frames are part of the stream. A decoder checks
+ *              the timing of a stream and recovers the frames, so the 
+ *              generation can be verified without hardware. Does not depend
+ *              on the Arduino core or ESP-IDF, so it is also checked on the
+ *              host.
+ *
+ * Notes: This code was written as part of my master's thesis at the
+ *        Institute for Microsensors, -actuators and -systems (IMSAS)
+ *        at the University of Bremen.
+ */
+
+#ifndef LT8722BITSTREAM_H
+#define LT8722BITSTREAM_H
+
+#include <stdint.h>
+#include <string.h>
+#include "LT8722Frame.h"
+
+#define LT8722_BITSTREAM_SCK      0x01  //bit of SCK in a sample
+#define LT8722_BITSTREAM_MOSI     0x02  //bit of MOSI in a sample
+#define LT8722_BITSTREAM_CS_SHIFT 2     //first bit of the chip select lanes
+#define LT8722_BITSTREAM_MAX_LANES 6    //chip select lanes of an 8-bit bus
+#define LT8722_BITSTREAM_IDLE     0xFC  //all chip selects high, SCK and MOSI low
+
+struct LT8722BitstreamTiming {
+    uint8_t setup;                      //samples with CS low before the first bit
+    uint8_t hold;                       //samples with CS low after the last bit
+    uint16_t gap;                       //samples with all CS high after the frame
+};
+
+struct LT8722BitstreamFrame {
+    uint8_t lane;                       //chip select lane of the frame
+    uint8_t length;                     //number of bytes
+    uint8_t data[8];                    //bytes of the frame
+    uint32_t start;                     //index of the sample where CS went low
+};
+
+class LT8722Bitstream {
+public:
+    /**************************************************************************/
+    /*!
+        @brief Create the encoder
+        @param timing Chip select setup, hold and gap in samples
+    */
+    /**************************************************************************/
+    LT8722Bitstream(LT8722BitstreamTiming timing = {1, 1, 2});
+
+    /**************************************************************************/
+    /*!
+        @brief Return the number of samples of one encoded frame
+        @param length Number of bytes of the frame
+        @return Number of samples including setup, hold and gap
+    */
+    /**************************************************************************/
+    uint32_t getFrameSamples(uint8_t length);
+
+    /**************************************************************************/
+    /*!
+        @brief Encode a complete frame for one chip select lane
+        @param lane Chip select lane (0 - 5)
+        @param frame Bytes of the frame, MSB first
+        @param length Number of bytes
+        @param output Output array for the samples
+        @param capacity Number of samples that fit into the output array
+        @return Number of samples written, 0 if the frame does not fit
+    */
+    /**************************************************************************/
+    uint32_t encodeFrame(uint8_t lane, const uint8_t *frame, uint8_t length, uint8_t *output, uint32_t capacity);
+
+    /**************************************************************************/
+    /*!
+        @brief Encode a write frame of the SPIS_DAC register (setpoint)
+        @param lane Chip select lane (0 - 5)
+        @param code Register value, e.g. from LT8722::voltageCode()
+        @param output Output array for the samples
+        @param capacity Number of samples that fit into the output array
+        @return Number of samples written, 0 if the frame does not fit
+    */
+    /**************************************************************************/
+    uint32_t encodeSetpoint(uint8_t lane, uint32_t code, uint8_t *output, uint32_t capacity);
+
+    /**************************************************************************/
+    /*!
+        @brief Fill samples with the idle state (all chip selects high)
+        @param output Output array for the samples
+        @param count Number of samples
+        @return Number of samples written
+    */
+    /**************************************************************************/
+    static uint32_t encodeIdle(uint8_t *output, uint32_t count);
+
+    /**************************************************************************/
+    /*!
+        @brief Recover the frames of a stream and check its timing: only one 
+               chip select low at a time, MOSI and chip selects stable while
+               SCK is high, setup, hold and gap at least as configured and 
+               whole bytes in every frame
+        @param samples Samples of the stream, starting in the idle state
+        @param count Number of samples
+        @param frames Output array for the decoded frames
+        @param maxFrames Number of frames that fit into the output array
+        @param violations Output for the number of timing violations
+        @return Number of decoded frames
+    */
+    /**************************************************************************/
+    uint32_t decode(const uint8_t *samples, uint32_t count, LT8722BitstreamFrame *frames, uint32_t maxFrames, uint32_t *violations);
+
+private:
+    LT8722BitstreamTiming _timing;
+};
+
+#endif
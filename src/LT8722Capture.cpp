@@ -0,0 +1,322 @@
+/*
+ * File Name: LT8722Capture.cpp
+ * Description: High-speed capture of the analog output of the LT8722. The
+ *              AMUX is parked on one value and the ADC runs in continuous
+ *              DMA mode at its maximum rate into a ring buffer in PSRAM.
+ *              Pre- and post-trigger samples are kept around a threshold,
+ *              status or manual trigger (e.g. a setpoint step) and the
+ *              capture can be exported as binary data over a stream.
+ *
+ * Notes: This code was written as part of my master's thesis at the
+ *        Institute for Microsensors, -actuators and -systems (IMSAS)
+ *        at the University of Bremen.
+ */
+
+#include "LT8722Capture.h"
+
+#if __has_include(<esp_adc/adc_continuous.h>)
+
+#if CONFIG_IDF_TARGET_ESP32 || CONFIG_IDF_TARGET_ESP32S2
+#define ADC_OUTPUT_FORMAT ADC_DIGI_OUTPUT_FORMAT_TYPE1
+#define ADC_GET_DATA(p) ((p)->type1.data)
+#else
+#define ADC_OUTPUT_FORMAT ADC_DIGI_OUTPUT_FORMAT_TYPE2
+#define ADC_GET_DATA(p) ((p)->type2.data)
+#endif
+
+/**************************************************************************/
+/*!
+    @brief Create the capture object
+*/
+/**************************************************************************/
+LT8722Capture::LT8722Capture() {
+    _buffer = NULL;
+    _sampleRate = 0;
+    _lastStatus = 0;
+    _device = NULL;
+    _adc = NULL;
+    _cali = NULL;
+}
+
+/**************************************************************************/
+/*!
+    @brief Stop the capture and free the ring buffer
+*/
+/**************************************************************************/
+LT8722Capture::~LT8722Capture() {
+    stop();
+    free(_buffer);
+}
+
+/**************************************************************************/
+/*!
+    @brief Allocate the ring buffer, preferably in PSRAM. The buffer of a
+           previous call is freed.
+    @param samples Number of samples of one capture
+    @param pretrigger Number of samples to be kept before the trigger
+    @return Error (True) if the number of samples is zero or the buffer
+            could not be allocated
+*/
+/**************************************************************************/
+bool LT8722Capture::begin(uint32_t samples, uint32_t pretrigger) {
+    if (_adc != NULL) {
+        stop();
+    }
+
+    free(_buffer);
+    _buffer = NULL;
+    _ring.begin(NULL, 0, 0);
+
+    if (samples == 0) {
+        return true;
+    }
+
+    _buffer = (uint16_t *)ps_malloc(samples * sizeof(uint16_t));
+    if (_buffer == NULL) {
+        _buffer = (uint16_t *)malloc(samples * sizeof(uint16_t)); //fallback to internal RAM without PSRAM
+    }
+
+    return _ring.begin(_buffer, samples, pretrigger);
+}
+
+/**************************************************************************/
+/*!
+    @brief Define the trigger of the capture
+    @param type Predefined trigger type
+    @param threshold Threshold in millivolts for RISING_EDGE and FALLING_EDGE
+*/
+/**************************************************************************/
+void LT8722Capture::setTrigger(CAPTURE_TRIGGER type, uint16_t threshold) {
+    _ring.setTrigger(type, threshold);
+}
+
+/**************************************************************************/
+/*!
+    @brief Park the AMUX of the device on the given value and start the
+           ADC in continuous mode
+    @param device LT8722 whose analog output is captured
+    @param value Predefined value of the analog output
+    @param sampleRate Sample rate in Hz (maximum rate of the ADC by default)
+    @return Error (True) if the SPI communication or the ADC failed, the
+            capture is already running or another owner holds the 
+            analog input
+*/
+/**************************************************************************/
+bool LT8722Capture::start(LT8722* device, ANALOG_OUTPUT value, uint32_t sampleRate) {
+    adc_unit_t unit;
+    adc_channel_t channel;
+
+    //a running capture has to be stopped first, its handles would be overwritten
+    if (_buffer == NULL || _adc != NULL || adc_continuous_io_to_channel(device->getAnalogInput(), &unit, &channel) != ESP_OK) {
+        return true;
+    }
+
+    //the line may be driven by another device with the same analog input
+    if (LT8722::lockAnalogInput(device->getAnalogInput(), this)) {
+        return true;
+    }
+
+    _device = device;
+    _sampleRate = sampleRate;
+
+    bool error = device->parkAnalogOutput(value);
+    if (_ring.getTrigger() == CAPTURE_TRIGGER::STATUS_CHANGE) {
+        _lastStatus = device->getStatus();
+    }
+
+    //configure the ADC for continuous conversions of a single pin
+    adc_continuous_handle_cfg_t handleConfig = {};
+    handleConfig.max_store_buf_size = 16384;
+    handleConfig.conv_frame_size = 1024;
+
+    adc_digi_pattern_config_t pattern = {};
+    pattern.atten = ADC_ATTEN_DB_12;
+    pattern.channel = channel;
+    pattern.unit = unit;
+    pattern.bit_width = SOC_ADC_DIGI_MAX_BITWIDTH;
+
+    adc_continuous_config_t config = {};
+    config.pattern_num = 1;
+    config.adc_pattern = &pattern;
+    config.sample_freq_hz = sampleRate;
+    config.conv_mode = (unit == ADC_UNIT_1) ? ADC_CONV_SINGLE_UNIT_1 : ADC_CONV_SINGLE_UNIT_2;
+    config.format = ADC_OUTPUT_FORMAT;
+
+#if ADC_CALI_SCHEME_CURVE_FITTING_SUPPORTED
+    adc_cali_curve_fitting_config_t caliConfig = {};
+    caliConfig.unit_id = unit;
+    caliConfig.chan = channel;
+    caliConfig.atten = ADC_ATTEN_DB_12;
+    caliConfig.bitwidth = ADC_BITWIDTH_12;
+    error |= adc_cali_create_scheme_curve_fitting(&caliConfig, &_cali) != ESP_OK;
+#else
+    adc_cali_line_fitting_config_t caliConfig = {};
+    caliConfig.unit_id = unit;
+    caliConfig.atten = ADC_ATTEN_DB_12;
+    caliConfig.bitwidth = ADC_BITWIDTH_12;
+    error |= adc_cali_create_scheme_line_fitting(&caliConfig, &_cali) != ESP_OK;
+#endif
+
+    error |= adc_continuous_new_handle(&handleConfig, &_adc) != ESP_OK;
+    if (!error) {
+        error |= adc_continuous_config(_adc, &config) != ESP_OK;
+        error |= adc_continuous_start(_adc) != ESP_OK;
+    }
+
+    if (error) {
+        stop();
+        return true;
+    }
+
+    _ring.arm();
+    return false;
+}
+
+/**************************************************************************/
+/*!
+    @brief Move the samples of the ADC into the ring buffer, has to be
+           called frequently (e.g. in the loop) while the capture runs
+    @return True if the capture is complete
+*/
+/**************************************************************************/
+bool LT8722Capture::service() {
+    uint8_t result[1024];
+    uint16_t samples[sizeof(result) / SOC_ADC_DIGI_RESULT_BYTES];
+    uint32_t length = 0;
+
+    while ((_ring.getState() == CAPTURE_STATE::ARMED || _ring.getState() == CAPTURE_STATE::TRIGGERED) &&
+           adc_continuous_read(_adc, result, sizeof(result), &length, 0) == ESP_OK) {
+        uint32_t count = 0;
+
+        //convert the raw DMA results to millivolts
+        for (uint32_t i = 0; i + SOC_ADC_DIGI_RESULT_BYTES <= length; i += SOC_ADC_DIGI_RESULT_BYTES) {
+            adc_digi_output_data_t *output = (adc_digi_output_data_t *)&result[i];
+            int millivolts = 0;
+            adc_cali_raw_to_voltage(_cali, ADC_GET_DATA(output), &millivolts);
+            samples[count] = millivolts;
+            count++;
+        }
+
+        //one status read per block of samples while waiting for a status change
+        if (_ring.getTrigger() == CAPTURE_TRIGGER::STATUS_CHANGE && _ring.getState() == CAPTURE_STATE::ARMED) {
+            uint16_t status = _device->getStatus();
+            if (status != _lastStatus) {
+                trigger();
+            }
+            _lastStatus = status;
+        }
+
+        push(samples, count);
+    }
+
+    if (_ring.getState() == CAPTURE_STATE::COMPLETE && _adc != NULL) {
+        stop();
+    }
+
+    return _ring.getState() == CAPTURE_STATE::COMPLETE;
+}
+
+/**************************************************************************/
+/*!
+    @brief Add samples to the capture and evaluate the trigger. Called by
+           service(), but can also be used with samples from other
+           sources (e.g. synthetic data)
+    @param samples Samples in millivolts
+    @param count Number of samples
+*/
+/**************************************************************************/
+void LT8722Capture::push(const uint16_t *samples, uint32_t count) {
+    _ring.push(samples, count);
+}
+
+/**************************************************************************/
+/*!
+    @brief Trigger the capture with the next sample, e.g. directly after
+           a setpoint step
+*/
+/**************************************************************************/
+void LT8722Capture::trigger() {
+    _ring.trigger();
+}
+
+/**************************************************************************/
+/*!
+    @brief Stop the ADC and disable the analog output of the device
+*/
+/**************************************************************************/
+void LT8722Capture::stop() {
+    if (_adc != NULL) {
+        adc_continuous_stop(_adc);
+        adc_continuous_deinit(_adc);
+        _adc = NULL;
+    }
+
+    if (_cali != NULL) {
+#if ADC_CALI_SCHEME_CURVE_FITTING_SUPPORTED
+        adc_cali_delete_scheme_curve_fitting(_cali);
+#else
+        adc_cali_delete_scheme_line_fitting(_cali);
+#endif
+        _cali = NULL;
+    }
+
+    if (_device != NULL) {
+        _device->releaseAnalogOutput();
+        LT8722::unlockAnalogInput(_device->getAnalogInput(), this);
+        _device = NULL;
+    }
+
+    _ring.stop();
+}
+
+/**************************************************************************/
+/*!
+    @brief Return the state of the capture
+    @return Predefined capture state
+*/
+/**************************************************************************/
+CAPTURE_STATE LT8722Capture::getState() {
+    return _ring.getState();
+}
+
+/**************************************************************************/
+/*!
+    @brief Copy the captured samples in chronological order
+    @param output Output array for the samples in millivolts
+    @param count Maximum number of samples to be copied
+    @return Number of copied samples
+*/
+/**************************************************************************/
+uint32_t LT8722Capture::read(uint16_t *output, uint32_t count) {
+    return _ring.read(output, count);
+}
+
+/**************************************************************************/
+/*!
+    @brief Write the capture as binary data: "LTCP", sample rate, number
+           of samples and index of the trigger sample as uint32_t, then
+           the samples in millivolts as uint16_t (all little endian)
+    @param stream Stream to be written to (e.g. Serial)
+    @return Number of bytes written
+*/
+/**************************************************************************/
+size_t LT8722Capture::exportTo(Stream &stream) {
+    const uint16_t *first;
+    const uint16_t *second;
+    uint32_t firstCount;
+    uint32_t secondCount;
+    uint32_t header[] = {_sampleRate, _ring.getCaptured(), _ring.getPretrigger()};
+    size_t written = 0;
+
+    written += stream.write((const uint8_t *)"LTCP", 4);
+    written += stream.write((const uint8_t *)header, sizeof(header));
+
+    //the ring buffer is written in at most two contiguous blocks
+    _ring.getBlocks(first, firstCount, second, secondCount);
+    written += stream.write((const uint8_t *)first, firstCount * sizeof(uint16_t));
+    written += stream.write((const uint8_t *)second, secondCount * sizeof(uint16_t));
+
+    return written;
+}
+
+#endif
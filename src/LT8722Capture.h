@@ -0,0 +1,155 @@
+/*
+ * File Name: LT8722Capture.h
+ * Description: High-speed capture of the analog output of the LT8722. The
+ *              AMUX is parked on one value and the ADC runs in continuous
+ *              DMA mode at its maximum rate into a ring buffer in PSRAM.
+ *              Pre- and post-trigger samples are kept around a threshold,
+ *              status or manual trigger (e.g. a setpoint step) and the
+ *              capture can be exported as binary data over a stream.
+ *
+ * Notes: This code was written as part of my master's thesis at the
+ *        Institute for Microsensors, -actuators and -systems (IMSAS)
+ *        at the University of Bremen.
+ */
+
+#ifndef LT8722CAPTURE_H
+#define LT8722CAPTURE_H
+
+#include <Arduino.h>
+#include "LT8722SampleRing.h"
+
+#if __has_include(<esp_adc/adc_continuous.h>)
+#include <esp_adc/adc_continuous.h>
+#include <esp_adc/adc_cali.h>
+#include <esp_adc/adc_cali_scheme.h>
+#include "LT8722.h"
+
+class LT8722Capture {
+public:
+    /**************************************************************************/
+    /*!
+        @brief Create the capture object
+    */
+    /**************************************************************************/
+    LT8722Capture();
+
+    /**************************************************************************/
+    /*!
+        @brief Stop the capture and free the ring buffer
+    */
+    /**************************************************************************/
+    ~LT8722Capture();
+
+    /**************************************************************************/
+    /*!
+        @brief Allocate the ring buffer, preferably in PSRAM. The buffer of a
+               previous call is freed.
+        @param samples Number of samples of one capture
+        @param pretrigger Number of samples to be kept before the trigger
+        @return Error (True) if the number of samples is zero or the buffer
+                could not be allocated
+    */
+    /**************************************************************************/
+    bool begin(uint32_t samples, uint32_t pretrigger);
+
+    /**************************************************************************/
+    /*!
+        @brief Define the trigger of the capture
+        @param type Predefined trigger type
+        @param threshold Threshold in millivolts for RISING_EDGE and FALLING_EDGE
+    */
+    /**************************************************************************/
+    void setTrigger(CAPTURE_TRIGGER type, uint16_t threshold = 0);
+
+    /**************************************************************************/
+    /*!
+        @brief Park the AMUX of the device on the given value and start the
+               ADC in continuous mode
+        @param device LT8722 whose analog output is captured
+        @param value Predefined value of the analog output
+        @param sampleRate Sample rate in Hz (maximum rate of the ADC by default)
+        @return Error (True) if the SPI communication or the ADC failed, the
+                capture is already running or another owner holds the 
+                analog input
+    */
+    /**************************************************************************/
+    bool start(LT8722* device, ANALOG_OUTPUT value, uint32_t sampleRate = SOC_ADC_SAMPLE_FREQ_THRES_HIGH);
+
+    /**************************************************************************/
+    /*!
+        @brief Move the samples of the ADC into the ring buffer, has to be
+               called frequently (e.g. in the loop) while the capture runs
+        @return True if the capture is complete
+    */
+    /**************************************************************************/
+    bool service();
+
+    /**************************************************************************/
+    /*!
+        @brief Add samples to the capture and evaluate the trigger. Called by
+               service(), but can also be used with samples from other
+               sources (e.g. synthetic data)
+        @param samples Samples in millivolts
+        @param count Number of samples
+    */
+    /**************************************************************************/
+    void push(const uint16_t *samples, uint32_t count);
+
+    /**************************************************************************/
+    /*!
+        @brief Trigger the capture with the next sample, e.g. directly after
+               a setpoint step
+    */
+    /**************************************************************************/
+    void trigger();
+
+    /**************************************************************************/
+    /*!
+        @brief Stop the ADC and disable the analog output of the device
+    */
+    /**************************************************************************/
+    void stop();
+
+    /**************************************************************************/
+    /*!
+        @brief Return the state of the capture
+        @return Predefined capture state
+    */
+    /**************************************************************************/
+    CAPTURE_STATE getState();
+
+    /**************************************************************************/
+    /*!
+        @brief Copy the captured samples in chronological order
+        @param output Output array for the samples in millivolts
+        @param count Maximum number of samples to be copied
+        @return Number of copied samples
+    */
+    /**************************************************************************/
+    uint32_t read(uint16_t *output, uint32_t count);
+
+    /**************************************************************************/
+    /*!
+        @brief Write the capture as binary data: "LTCP", sample rate, number
+               of samples and index of the trigger sample as uint32_t, then
+               the samples in millivolts as uint16_t (all little endian)
+        @param stream Stream to be written to (e.g. Serial)
+        @return Number of bytes written
+    */
+    /**************************************************************************/
+    size_t exportTo(Stream &stream);
+
+private:
+    LT8722SampleRing _ring;
+    uint16_t *_buffer;
+    uint32_t _sampleRate;
+    uint16_t _lastStatus;
+
+    LT8722 *_device;
+    adc_continuous_handle_t _adc;
+    adc_cali_handle_t _cali;
+};
+
+#endif
+
+#endif
@@ -0,0 +1,55 @@
+/*
+ * File Name: LT8722Config.h
+ * Description: Compile time options of the LT8722 library. The options are
+ *              set with build flags (e.g. build_flags = -DLT8722_USE_IRAM
+ *              in the platformio.ini).
+ *
+ * Notes: This code was written as part of my master's thesis at the 
+ *        Institute for Microsensors, -actuators and -systems (IMSAS) 
+ *        at the University of Bremen.
+ */
+
+#ifndef LT8722CONFIG_H
+#define LT8722CONFIG_H
+
+#ifdef ESP_PLATFORM
+#include <esp_attr.h>
+#else
+#define IRAM_ATTR                //host builds (make -C test) have no memory sections of the ESP32
+#define DRAM_ATTR
+#endif
+
+//LT8722_USE_IRAM places the frame path, the CRC table, the chip select and 
+//the setpoint functions in internal RAM, so they keep running while the 
+//flash cache is disabled (e.g. during NVS or LittleFS writes)
+#ifdef LT8722_USE_IRAM
+#define LT8722_IRAM_ATTR IRAM_ATTR
+#define LT8722_DRAM_ATTR DRAM_ATTR
+#else
+#define LT8722_IRAM_ATTR
+#define LT8722_DRAM_ATTR
+#endif
+
+//LT8722_CRC selects the implementation of the CRC calculation, all of them
+//produce identical results:
+//LT8722_CRC_TABLE       256 byte lookup table in flash (in RAM with LT8722_USE_IRAM)
+//LT8722_CRC_TABLE_RAM   256 byte lookup table in internal RAM (default)
+//LT8722_CRC_NIBBLE      16 byte lookup table in internal RAM, two lookups per byte
+//LT8722_CRC_BITWISE     branch-free bitwise calculation without any table
+#define LT8722_CRC_TABLE     0
+#define LT8722_CRC_TABLE_RAM 1
+#define LT8722_CRC_NIBBLE    2
+#define LT8722_CRC_BITWISE   3
+
+//the example CRC_Benchmark.cpp measures the cycles per frame of all variants
+//on the target, warm and under cache pressure; the default has to be the 
+//fastest cold variant
+#ifndef LT8722_CRC
+#define LT8722_CRC LT8722_CRC_TABLE_RAM
+#endif
+
+//LT8722_FAULT_INJECTION passes every frame and the analog output check of
+//checkHealth() through LT8722FaultInjection to measure the detection and 
+//recovery of faults, not intended for production builds
+
+#endif
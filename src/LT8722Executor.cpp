@@ -0,0 +1,374 @@
+/*
+ * File Name: LT8722Executor.cpp
+ * Description: Executor for the per-channel control work (e.g. PID,
+ *              estimation and recipes) of many LT8722. Every cycle the
+ *              compute tasks of all channels are distributed to worker
+ *              threads with work-stealing deques, on the ESP32 the workers
+ *              are pinned to both cores. The SPI frames are issued in a
+ *              separate stage in channel order, each channel as soon as
+ *              its compute task has finished. Only the C++ standard
+ *              library is used, so the executor also runs on a host.
+ *
+ * Notes: This code was written as part of my master's thesis at the
+ *        Institute for Microsensors, -actuators and -systems (IMSAS)
+ *        at the University of Bremen.
+ */
+
+#include "LT8722Executor.h"
+#include <chrono>
+
+#ifdef ESP_PLATFORM
+#include <esp_pthread.h>
+#endif
+
+/**************************************************************************/
+/*!
+    @brief Create the executor object
+*/
+/**************************************************************************/
+LT8722Executor::LT8722Executor() {
+    _channels = 0;
+    _workers = 0;
+    _generation = 0;
+    _running = false;
+    _active = 0;
+    _period = 0;
+    _deadlineMisses = 0;
+    _statisticsStart = 0;
+
+    for (uint8_t i = 0; i < LT8722_EXECUTOR_MAX_CHANNELS; i++) {
+        _compute[i] = NULL;
+        _issue[i] = NULL;
+        _context[i] = NULL;
+        _done[i] = false;
+    }
+
+    for (uint8_t i = 0; i < LT8722_EXECUTOR_MAX_WORKERS; i++) {
+        _deques[i].top = 0;
+        _deques[i].bottom = 0;
+        _busy[i] = 0;
+        _steals[i] = 0;
+    }
+}
+
+/**************************************************************************/
+/*!
+    @brief Stop and join the worker threads
+*/
+/**************************************************************************/
+LT8722Executor::~LT8722Executor() {
+    //a joinable std::thread must not be destroyed
+    end();
+}
+
+/**************************************************************************/
+/*!
+    @brief Start the worker threads, on the ESP32 they are distributed
+           over both cores
+    @param workers Number of worker threads
+    @param period Period of one cycle in microseconds (deadline)
+    @return Error (True) if the number of workers is not supported
+*/
+/**************************************************************************/
+bool LT8722Executor::begin(uint8_t workers, uint32_t period) {
+    if (workers == 0 || workers > LT8722_EXECUTOR_MAX_WORKERS || _running) {
+        return true;
+    }
+
+    _workers = workers;
+    _period = period;
+    _running = true;
+
+    for (uint8_t i = 0; i < _workers; i++) {
+#ifdef ESP_PLATFORM
+        //pin the workers alternately to both cores
+        esp_pthread_cfg_t config = esp_pthread_get_default_config();
+        config.pin_to_core = i % portNUM_PROCESSORS;
+        config.stack_size = 4096;
+        esp_pthread_set_cfg(&config);
+#endif
+        _threads[i] = std::thread(&LT8722Executor::work, this, i, _generation);
+    }
+
+#ifdef ESP_PLATFORM
+    //threads created later by the application get the default configuration again
+    esp_pthread_cfg_t config = esp_pthread_get_default_config();
+    esp_pthread_set_cfg(&config);
+#endif
+
+    resetStatistics();
+    return false;
+}
+
+/**************************************************************************/
+/*!
+    @brief Stop and join the worker threads, does nothing if the 
+           executor was not started
+*/
+/**************************************************************************/
+void LT8722Executor::end() {
+    if (!_running && _workers == 0) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _running = false;
+        _generation++;
+    }
+    _start.notify_all();
+
+    for (uint8_t i = 0; i < _workers; i++) {
+        if (_threads[i].joinable()) {
+            _threads[i].join();
+        }
+    }
+    _workers = 0;
+}
+
+/**************************************************************************/
+/*!
+    @brief Add a channel with its compute and issue function
+    @param compute Control work of the channel, runs on any worker
+    @param issue SPI frame issue of the channel, runs in the issue stage
+           after compute in channel order
+    @param context Pointer passed to both functions (e.g. the LT8722)
+    @return Error (True) if no more channels can be added
+*/
+/**************************************************************************/
+bool LT8722Executor::addChannel(LT8722ChannelFunction compute, LT8722ChannelFunction issue, void *context) {
+    if (_channels >= LT8722_EXECUTOR_MAX_CHANNELS || compute == NULL) {
+        return true;
+    }
+
+    _compute[_channels] = compute;
+    _issue[_channels] = issue;
+    _context[_channels] = context;
+    _channels++;
+
+    return false;
+}
+
+/**************************************************************************/
+/*!
+    @brief Run one cycle: compute all channels on the workers and issue
+           them in channel order on the calling thread
+    @return True if the cycle missed its deadline or no workers are running
+*/
+/**************************************************************************/
+bool LT8722Executor::runCycle() {
+    uint64_t start = now();
+    int32_t count[LT8722_EXECUTOR_MAX_WORKERS] = {0};
+
+    if (_workers == 0) {
+        return true;
+    }
+
+    //distribute the channels round-robin, workers that run out of tasks steal the rest
+    for (uint8_t i = 0; i < _channels; i++) {
+        uint8_t worker = i % _workers;
+        _deques[worker].tasks[count[worker]] = i;
+        count[worker]++;
+        _done[i].store(false);
+    }
+    for (uint8_t i = 0; i < _workers; i++) {
+        _deques[i].top.store(0);
+        _deques[i].bottom.store(count[i]);
+    }
+
+    _active = _workers;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _generation++;
+    }
+    _start.notify_all();
+
+    //issue stage: frames of a channel are issued only after its compute task
+    for (uint8_t i = 0; i < _channels; i++) {
+        while (!_done[i].load(std::memory_order_acquire)) {
+            std::this_thread::yield();
+        }
+        if (_issue[i] != NULL) {
+            _issue[i](i, _context[i]);
+        }
+    }
+
+    //all workers have to be idle before the deques are filled again
+    while (_active.load() != 0) {
+        std::this_thread::yield();
+    }
+
+    bool missed = (now() - start) > _period;
+    if (missed) {
+        _deadlineMisses++;
+    }
+
+    return missed;
+}
+
+/**************************************************************************/
+/*!
+    @brief Return the utilization of a worker since the last reset, on
+           the ESP32 worker i runs on core i % portNUM_PROCESSORS
+    @param worker Index of the worker
+    @return Busy time divided by the elapsed time (0.0 - 1.0)
+*/
+/**************************************************************************/
+float LT8722Executor::getUtilization(uint8_t worker) {
+    uint64_t elapsed = now() - _statisticsStart;
+
+    if (worker >= _workers || elapsed == 0) {
+        return 0.0;
+    }
+
+    return (float)_busy[worker].load() / elapsed;
+}
+
+/**************************************************************************/
+/*!
+    @brief Return the number of tasks a worker has stolen from others
+    @param worker Index of the worker
+    @return Number of stolen tasks since the last reset
+*/
+/**************************************************************************/
+uint32_t LT8722Executor::getSteals(uint8_t worker) {
+    return (worker < _workers) ? _steals[worker].load() : 0;
+}
+
+/**************************************************************************/
+/*!
+    @brief Return the number of cycles that missed their deadline
+    @return Number of deadline misses since the last reset
+*/
+/**************************************************************************/
+uint32_t LT8722Executor::getDeadlineMisses() {
+    return _deadlineMisses;
+}
+
+/**************************************************************************/
+/*!
+    @brief Reset utilization, steals and deadline misses
+*/
+/**************************************************************************/
+void LT8722Executor::resetStatistics() {
+    for (uint8_t i = 0; i < LT8722_EXECUTOR_MAX_WORKERS; i++) {
+        _busy[i] = 0;
+        _steals[i] = 0;
+    }
+    _deadlineMisses = 0;
+    _statisticsStart = now();
+}
+
+/**************************************************************************/
+/*!
+    @brief Loop of a worker thread
+    @param worker Index of the worker
+    @param generation Generation at the start, the first cycle is the next one
+*/
+/**************************************************************************/
+void LT8722Executor::work(uint8_t worker, uint32_t generation) {
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _start.wait(lock, [&] { return _generation != generation; });
+            generation = _generation;
+            if (!_running) {
+                return;
+            }
+        }
+
+        uint64_t busyStart = now();
+
+        while (true) {
+            int16_t channel = pop(worker);
+
+            //steal from the other workers if the own deque is empty
+            for (uint8_t i = 1; i < _workers && channel == -1; i++) {
+                channel = steal((worker + i) % _workers);
+            }
+
+            if (channel >= 0) {
+                if (channel % _workers != worker) {
+                    _steals[worker]++;                          //channel was distributed to another worker
+                }
+                _compute[channel](channel, _context[channel]);
+                _done[channel].store(true, std::memory_order_release);
+                continue;
+            }
+
+            //a lost race (-2) is retried, otherwise all deques are empty
+            if (channel == -1) {
+                break;
+            }
+        }
+
+        _busy[worker] += now() - busyStart;
+        _active--;
+    }
+}
+
+/**************************************************************************/
+/*!
+    @brief Take a task from the bottom of the own deque
+    @param worker Index of the worker
+    @return Channel or -1 if the deque is empty
+*/
+/**************************************************************************/
+int16_t LT8722Executor::pop(uint8_t worker) {
+    Deque &deque = _deques[worker];
+    int32_t bottom = deque.bottom.load() - 1;
+    deque.bottom.store(bottom);
+    int32_t top = deque.top.load();
+
+    if (top > bottom) {
+        deque.bottom.store(bottom + 1);
+        return -1;
+    }
+
+    int16_t channel = deque.tasks[bottom];
+
+    //the last task can be stolen at the same time
+    if (top == bottom) {
+        if (!deque.top.compare_exchange_strong(top, top + 1)) {
+            channel = -1;
+        }
+        deque.bottom.store(bottom + 1);
+    }
+
+    return channel;
+}
+
+/**************************************************************************/
+/*!
+    @brief Take a task from the top of the deque of another worker
+    @param victim Index of the worker to steal from
+    @return Channel, -1 if the deque is empty or -2 if another worker was
+            faster
+*/
+/**************************************************************************/
+int16_t LT8722Executor::steal(uint8_t victim) {
+    Deque &deque = _deques[victim];
+    int32_t top = deque.top.load();
+    int32_t bottom = deque.bottom.load();
+
+    if (top >= bottom) {
+        return -1;
+    }
+
+    int16_t channel = deque.tasks[top];
+    if (!deque.top.compare_exchange_strong(top, top + 1)) {
+        return -2;
+    }
+
+    return channel;
+}
+
+/**************************************************************************/
+/*!
+    @brief Return the time of a monotonic clock
+    @return Time in microseconds
+*/
+/**************************************************************************/
+uint64_t LT8722Executor::now() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
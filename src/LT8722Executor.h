@@ -0,0 +1,196 @@
+/*
+ * File Name: LT8722Executor.h
+ * Description: Executor for the per-channel control work (e.g. PID,
+ *              estimation and recipes) of many LT8722. Every cycle the
+ *              compute tasks of all channels are distributed to worker
+ *              threads with work-stealing deques, on the ESP32 the workers
+ *              are pinned to both cores. The SPI frames are issued in a
+ *              separate stage in channel order, each channel as soon as
+ *              its compute task has finished. Only the C++ standard
+ *              library is used, so the executor also runs on a host.
+ *
+ * Notes: This code was written as part of my master's thesis at the
+ *        Institute for Microsensors, -actuators and -systems (IMSAS)
+ *        at the University of Bremen.
+ */
+
+#ifndef LT8722EXECUTOR_H
+#define LT8722EXECUTOR_H
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#ifndef LT8722_EXECUTOR_MAX_CHANNELS
+#define LT8722_EXECUTOR_MAX_CHANNELS 64
+#endif
+
+#ifndef LT8722_EXECUTOR_MAX_WORKERS
+#define LT8722_EXECUTOR_MAX_WORKERS 4
+#endif
+
+typedef void (*LT8722ChannelFunction)(uint8_t channel, void *context);
+
+class LT8722Executor {
+public:
+    /**************************************************************************/
+    /*!
+        @brief Create the executor object
+    */
+    /**************************************************************************/
+    LT8722Executor();
+
+    /**************************************************************************/
+    /*!
+        @brief Stop and join the worker threads
+    */
+    /**************************************************************************/
+    ~LT8722Executor();
+
+    /**************************************************************************/
+    /*!
+        @brief Start the worker threads, on the ESP32 they are distributed
+               over both cores
+        @param workers Number of worker threads
+        @param period Period of one cycle in microseconds (deadline)
+        @return Error (True) if the number of workers is not supported
+    */
+    /**************************************************************************/
+    bool begin(uint8_t workers, uint32_t period);
+
+    /**************************************************************************/
+    /*!
+        @brief Stop and join the worker threads, does nothing if the 
+               executor was not started
+    */
+    /**************************************************************************/
+    void end();
+
+    /**************************************************************************/
+    /*!
+        @brief Add a channel with its compute and issue function
+        @param compute Control work of the channel, runs on any worker
+        @param issue SPI frame issue of the channel, runs in the issue stage
+               after compute in channel order
+        @param context Pointer passed to both functions (e.g. the LT8722)
+        @return Error (True) if no more channels can be added
+    */
+    /**************************************************************************/
+    bool addChannel(LT8722ChannelFunction compute, LT8722ChannelFunction issue, void *context);
+
+    /**************************************************************************/
+    /*!
+        @brief Run one cycle: compute all channels on the workers and issue
+               them in channel order on the calling thread
+        @return True if the cycle missed its deadline or no workers are running
+    */
+    /**************************************************************************/
+    bool runCycle();
+
+    /**************************************************************************/
+    /*!
+        @brief Return the utilization of a worker since the last reset, on
+               the ESP32 worker i runs on core i % portNUM_PROCESSORS
+        @param worker Index of the worker
+        @return Busy time divided by the elapsed time (0.0 - 1.0)
+    */
+    /**************************************************************************/
+    float getUtilization(uint8_t worker);
+
+    /**************************************************************************/
+    /*!
+        @brief Return the number of tasks a worker has stolen from others
+        @param worker Index of the worker
+        @return Number of stolen tasks since the last reset
+    */
+    /**************************************************************************/
+    uint32_t getSteals(uint8_t worker);
+
+    /**************************************************************************/
+    /*!
+        @brief Return the number of cycles that missed their deadline
+        @return Number of deadline misses since the last reset
+    */
+    /**************************************************************************/
+    uint32_t getDeadlineMisses();
+
+    /**************************************************************************/
+    /*!
+        @brief Reset utilization, steals and deadline misses
+    */
+    /**************************************************************************/
+    void resetStatistics();
+
+private:
+    struct Deque {
+        uint8_t tasks[LT8722_EXECUTOR_MAX_CHANNELS];
+        std::atomic<int32_t> top;
+        std::atomic<int32_t> bottom;
+    };
+
+    /**************************************************************************/
+    /*!
+        @brief Loop of a worker thread
+        @param worker Index of the worker
+        @param generation Generation at the start, the first cycle is the next one
+    */
+    /**************************************************************************/
+    void work(uint8_t worker, uint32_t generation);
+
+    /**************************************************************************/
+    /*!
+        @brief Take a task from the bottom of the own deque
+        @param worker Index of the worker
+        @return Channel or -1 if the deque is empty
+    */
+    /**************************************************************************/
+    int16_t pop(uint8_t worker);
+
+    /**************************************************************************/
+    /*!
+        @brief Take a task from the top of the deque of another worker
+        @param victim Index of the worker to steal from
+        @return Channel, -1 if the deque is empty or -2 if another worker was
+                faster
+    */
+    /**************************************************************************/
+    int16_t steal(uint8_t victim);
+
+    /**************************************************************************/
+    /*!
+        @brief Return the time of a monotonic clock
+        @return Time in microseconds
+    */
+    /**************************************************************************/
+    static uint64_t now();
+
+    LT8722ChannelFunction _compute[LT8722_EXECUTOR_MAX_CHANNELS];
+    LT8722ChannelFunction _issue[LT8722_EXECUTOR_MAX_CHANNELS];
+    void *_context[LT8722_EXECUTOR_MAX_CHANNELS];
+    std::atomic<bool> _done[LT8722_EXECUTOR_MAX_CHANNELS];
+    uint8_t _channels;
+
+    Deque _deques[LT8722_EXECUTOR_MAX_WORKERS];
+    std::thread _threads[LT8722_EXECUTOR_MAX_WORKERS];
+    std::atomic<uint64_t> _busy[LT8722_EXECUTOR_MAX_WORKERS];
+    std::atomic<uint32_t> _steals[LT8722_EXECUTOR_MAX_WORKERS];
+    uint8_t _workers;
+
+    std::mutex _mutex;
+    std::condition_variable _start;
+    uint32_t _generation;
+    bool _running;
+    std::atomic<uint8_t> _active;
+
+    uint32_t _period;
+    uint32_t _deadlineMisses;
+    uint64_t _statisticsStart;
+};
+
+#endif
@@ -0,0 +1,216 @@
+/*
+ * File Name: LT8722FaultInjection.cpp
+ * Description: Scripted fault injection for the LT8722 library. Every frame
+ *              passes through LT8722FaultInjection::process(), which can
+ *              drop the acknowledge, corrupt the CRC, latch the overcurrent
+ *              or thermal shutdown bit, report the command register as reset
+ *              to its defaults or hold the analog output at a fixed voltage.
+ *              The faults are emulated on the received data, so the recovery
+ *              of the library can be measured on a working setup. Only
+ *              compiled with the build flag LT8722_FAULT_INJECTION.
+ *
+ * Notes: This code was written as part of my master's thesis at the
+ *        Institute for Microsensors, -actuators and -systems (IMSAS)
+ *        at the University of Bremen.
+ */
+
+#include "LT8722FaultInjection.h"
+#include "CRC8.h"
+
+#ifdef LT8722_FAULT_INJECTION
+
+#define STUCK_MILLIVOLTS 0          //voltage of a stuck analog output in mV
+#define RESET_REGISTERS  0x6C       //limit registers 0x02, 0x03, 0x05 and 0x06 affected by a register reset
+
+//default values of the registers after a reset, indexed by the address
+static const uint16_t DEFAULT_VALUES[7] = {0x0000, 0x0000, 0x01FF, 0x0000, 0x0000, 0x000F, 0x0000};
+
+uint8_t LT8722FaultInjection::_cs = 0;
+FAULT LT8722FaultInjection::_fault = FAULT::NONE;
+uint32_t LT8722FaultInjection::_remaining = 0;
+uint8_t LT8722FaultInjection::_resetRegisters = 0;
+uint32_t LT8722FaultInjection::_frames = 0;
+
+/**************************************************************************/
+/*!
+    @brief Inject a fault into the frames of one device. Dropped 
+           acknowledges and corrupted CRCs affect the given number of 
+           frames and a stuck analog output the given number of 
+           measurements. Latched faults stay until the library clears
+           them (status register cleared or command register written).
+           A register reset also shows the limit registers (0x02, 0x03,
+           0x05 and 0x06) with their default values until each of them
+           is written again.
+    @param cs Chip select (cs) pin of the device
+    @param fault Fault to be injected
+    @param frames Number of frames or measurements affected
+    @return Error (True) if a dropped acknowledge, a corrupted CRC or a
+            stuck analog output should affect zero frames, nothing is 
+            injected then
+*/
+/**************************************************************************/
+bool LT8722FaultInjection::inject(uint8_t cs, FAULT fault, uint32_t frames) {
+    //the counter of these faults would wrap and never end
+    if (frames == 0 && (fault == FAULT::NO_ACK || fault == FAULT::CRC_ERROR || fault == FAULT::STUCK_ANALOG_OUTPUT)) {
+        return true;
+    }
+
+    _cs = cs;
+    _remaining = frames;
+    _resetRegisters = (fault == FAULT::REGISTER_RESET) ? RESET_REGISTERS : 0;
+    _fault = fault;
+
+    return false;
+}
+
+/**************************************************************************/
+/*!
+    @brief Remove the injected fault
+*/
+/**************************************************************************/
+void LT8722FaultInjection::clear() {
+    _fault = FAULT::NONE;
+    _resetRegisters = 0;
+}
+
+/**************************************************************************/
+/*!
+    @brief Return the fault that is currently injected
+    @return Injected fault, NONE if it was cleared
+*/
+/**************************************************************************/
+FAULT LT8722FaultInjection::getFault() {
+    return _fault;
+}
+
+/**************************************************************************/
+/*!
+    @brief Return the limit registers that still read back with their
+           default values after an injected register reset
+    @return Bit mask with one bit per register address
+*/
+/**************************************************************************/
+uint8_t LT8722FaultInjection::getResetRegisters() {
+    return _resetRegisters;
+}
+
+/**************************************************************************/
+/*!
+    @brief Apply the injected fault to a frame, called by transferFrame()
+    @param cs Chip select (cs) pin of the device
+    @param sendingPacket Sent frame
+    @param receivedPacket Received frame, modified by the fault
+    @param length Length of the frame in bytes
+*/
+/**************************************************************************/
+void LT8722FaultInjection::process(uint8_t cs, uint8_t *sendingPacket, uint8_t *receivedPacket, uint8_t length) {
+    _frames++;
+
+    if (cs != _cs) {
+        return;
+    }
+
+    bool readFrame = (sendingPacket[0] == 0xF4);
+    bool writeFrame = (sendingPacket[0] == 0xF2);
+    uint8_t address = sendingPacket[1] >> 1;
+    uint8_t crcIndex = readFrame ? 6 : 2;                   //CRC over the first two or six bytes of the response
+
+    //limit registers read back with their default values until they are written again, also after the command register
+    if (address < 7 && (_resetRegisters & (1 << address))) {
+        if (writeFrame) {
+            _resetRegisters &= ~(1 << address);
+        } else if (readFrame) {
+            receivedPacket[2] = 0x00;
+            receivedPacket[3] = 0x00;
+            receivedPacket[4] = DEFAULT_VALUES[address] >> 8;
+            receivedPacket[5] = DEFAULT_VALUES[address];
+            receivedPacket[6] = getCRC6(receivedPacket, receivedPacket + 2);
+        }
+    }
+
+    if (_fault == FAULT::NONE) {
+        return;
+    }
+
+    switch (_fault) {
+        case FAULT::NO_ACK:
+            receivedPacket[length - 1] = 0x00;
+            break;
+        case FAULT::CRC_ERROR:
+            receivedPacket[crcIndex] ^= 0x01;
+            break;
+        case FAULT::OVER_CURRENT:
+        case FAULT::OVER_TEMPERATURE:
+            //latched until the status register is cleared
+            if (writeFrame && address == 0x01) {
+                _fault = FAULT::NONE;
+                return;
+            }
+            receivedPacket[1] |= (_fault == FAULT::OVER_CURRENT) ? 0x20 : 0x40;
+            receivedPacket[crcIndex] = readFrame ? getCRC6(receivedPacket, receivedPacket + 2) : getCRC2(receivedPacket);
+            break;
+        case FAULT::REGISTER_RESET:
+            //the command register reads back with the output disabled until it is written again
+            if (writeFrame && address == 0x00) {
+                _fault = FAULT::NONE;
+                return;
+            }
+            if (readFrame && address == 0x00) {
+                receivedPacket[5] &= ~0x03;
+                receivedPacket[6] = getCRC6(receivedPacket, receivedPacket + 2);
+            }
+            break;
+        default:
+            return;
+    }
+
+    //dropped acknowledges and corrupted CRCs only affect a number of frames
+    if (_fault == FAULT::NO_ACK || _fault == FAULT::CRC_ERROR) {
+        _remaining--;
+        if (_remaining == 0) {
+            _fault = FAULT::NONE;
+        }
+    }
+}
+
+/**************************************************************************/
+/*!
+    @brief Apply a stuck analog output to a measured voltage
+    @param cs Chip select (cs) pin of the device
+    @param millivolts Measured voltage of the analog output in mV
+    @return Measured or stuck voltage in mV
+*/
+/**************************************************************************/
+uint32_t LT8722FaultInjection::analog(uint8_t cs, uint32_t millivolts) {
+    if (_fault != FAULT::STUCK_ANALOG_OUTPUT || cs != _cs) {
+        return millivolts;
+    }
+
+    _remaining--;
+    if (_remaining == 0) {
+        _fault = FAULT::NONE;
+    }
+
+    return STUCK_MILLIVOLTS;
+}
+
+/**************************************************************************/
+/*!
+    @brief Return the number of frames since the last reset
+    @return Number of frames of all devices
+*/
+/**************************************************************************/
+uint32_t LT8722FaultInjection::getFrames() {
+    return _frames;
+}
+
+/**************************************************************************/
+/*!
+    @brief Reset the number of frames
+*/
+/**************************************************************************/
+void LT8722FaultInjection::resetFrames() {
+    _frames = 0;
+}
+
+#endif
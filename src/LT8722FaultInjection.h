@@ -0,0 +1,117 @@
+/*
+ * File Name: LT8722FaultInjection.h
+ * Description: Scripted fault injection for the LT8722 library. Every frame
+ *              passes through LT8722FaultInjection::process(), which can
+ *              drop the acknowledge, corrupt the CRC, latch the overcurrent
+ *              or thermal shutdown bit, report the command register as reset
+ *              to its defaults or hold the analog output at a fixed voltage.
+ *              The faults are emulated on the received data, so the recovery
+ *              of the library can be measured on a working setup. Only
+ *              compiled with the build flag LT8722_FAULT_INJECTION.
+ *
+ * Notes: This code was written as part of my master's thesis at the
+ *        Institute for Microsensors, -actuators and -systems (IMSAS)
+ *        at the University of Bremen.
+ */
+
+#ifndef LT8722FAULTINJECTION_H
+#define LT8722FAULTINJECTION_H
+
+#include <Arduino.h>
+#include "LT8722.h"
+
+#ifdef LT8722_FAULT_INJECTION
+
+class LT8722FaultInjection {
+public:
+    /**************************************************************************/
+    /*!
+        @brief Inject a fault into the frames of one device. Dropped 
+               acknowledges and corrupted CRCs affect the given number of 
+               frames and a stuck analog output the given number of 
+               measurements. Latched faults stay until the library clears
+               them (status register cleared or command register written).
+               A register reset also shows the limit registers (0x02, 0x03,
+               0x05 and 0x06) with their default values until each of them
+               is written again.
+        @param cs Chip select (cs) pin of the device
+        @param fault Fault to be injected
+        @param frames Number of frames or measurements affected
+        @return Error (True) if a dropped acknowledge, a corrupted CRC or a
+                stuck analog output should affect zero frames, nothing is 
+                injected then
+    */
+    /**************************************************************************/
+    static bool inject(uint8_t cs, FAULT fault, uint32_t frames = 1);
+
+    /**************************************************************************/
+    /*!
+        @brief Remove the injected fault
+    */
+    /**************************************************************************/
+    static void clear();
+
+    /**************************************************************************/
+    /*!
+        @brief Return the fault that is currently injected
+        @return Injected fault, NONE if it was cleared
+    */
+    /**************************************************************************/
+    static FAULT getFault();
+
+    /**************************************************************************/
+    /*!
+        @brief Return the limit registers that still read back with their
+               default values after an injected register reset
+        @return Bit mask with one bit per register address
+    */
+    /**************************************************************************/
+    static uint8_t getResetRegisters();
+
+    /**************************************************************************/
+    /*!
+        @brief Apply the injected fault to a frame, called by transferFrame()
+        @param cs Chip select (cs) pin of the device
+        @param sendingPacket Sent frame
+        @param receivedPacket Received frame, modified by the fault
+        @param length Length of the frame in bytes
+    */
+    /**************************************************************************/
+    static void process(uint8_t cs, uint8_t *sendingPacket, uint8_t *receivedPacket, uint8_t length);
+
+    /**************************************************************************/
+    /*!
+        @brief Apply a stuck analog output to a measured voltage
+        @param cs Chip select (cs) pin of the device
+        @param millivolts Measured voltage of the analog output in mV
+        @return Measured or stuck voltage in mV
+    */
+    /**************************************************************************/
+    static uint32_t analog(uint8_t cs, uint32_t millivolts);
+
+    /**************************************************************************/
+    /*!
+        @brief Return the number of frames since the last reset
+        @return Number of frames of all devices
+    */
+    /**************************************************************************/
+    static uint32_t getFrames();
+
+    /**************************************************************************/
+    /*!
+        @brief Reset the number of frames
+    */
+    /**************************************************************************/
+    static void resetFrames();
+
+private:
+    static uint8_t _cs;
+    static FAULT _fault;
+    static uint32_t _remaining;
+    static uint8_t _resetRegisters;
+    static uint32_t _frames;
+};
+
+#endif
+
+#endif
@@ -0,0 +1,36 @@
+/*
+ * File Name: LT8722Frame.cpp
+ * Description: Encoding of complete LT8722 frames, so that they can be 
+ *              sent later without any calculations (e.g. from interrupts or
+ *              by DMA). Does not depend on the Arduino core or ESP-IDF, so
+ *              it is also checked on the host.
+ *
+ * Notes: This code was written as part of my master's thesis at the
+ *        Institute for Microsensors, -actuators and -systems (IMSAS)
+ *        at the University of Bremen.
+ */
+
+#include "LT8722Frame.h"
+#include "CRC8.h"
+
+/**************************************************************************/
+/*!
+    @brief Encode a complete write frame (command, address, data, CRC and 
+           ack placeholder) so that it can be sent later without any 
+           calculations
+    @param address Address of the register to be written to
+    @param data Data to be written to the register
+    @param frame Output array with a length of eight bytes
+*/
+/**************************************************************************/
+void LT8722_IRAM_ATTR encodeWriteFrame(uint8_t address, uint8_t *data, uint8_t *frame) {
+  frame[0] = 0xF2;                              //data write command
+  frame[1] = (address << 1) & 0xFE;             //register address A[7:1] 
+
+  for (uint8_t i = 0; i < 4; i++) {
+    frame[i + 2] = data[i];
+  }
+
+  frame[6] = getCRC6(frame, data);
+  frame[7] = 0x00;                              //placeholder for the ack byte
+}
@@ -0,0 +1,30 @@
+/*
+ * File Name: LT8722Frame.h
+ * Description: Encoding of complete LT8722 frames, so that they can be 
+ *              sent later without any calculations (e.g. from interrupts or
+ *              by DMA). Does not depend on the Arduino core or ESP-IDF, so
+ *              it is also checked on the host.
+ *
+ * Notes: This code was written as part of my master's thesis at the
+ *        Institute for Microsensors, -actuators and -systems (IMSAS)
+ *        at the University of Bremen.
+ */
+
+#ifndef LT8722FRAME_H
+#define LT8722FRAME_H
+
+#include <stdint.h>
+
+/**************************************************************************/
+/*!
+    @brief Encode a complete write frame (command, address, data, CRC and 
+           ack placeholder) so that it can be sent later without any 
+           calculations
+    @param address Address of the register to be written to
+    @param data Data to be written to the register
+    @param frame Output array with a length of eight bytes
+*/
+/**************************************************************************/
+void encodeWriteFrame(uint8_t address, uint8_t *data, uint8_t *frame);
+
+#endif
@@ -0,0 +1,75 @@
+/*
+ * File Name: LT8722FrequencyResponse.cpp
+ * Description: Measurement of the frequency response (gain and phase) of
+ *              the loop driven by the LT8722. A stepped sine is injected
+ *              through the output voltage and the response is sampled in
+ *              lockstep. Gain and phase are calculated incrementally with
+ *              Goertzel filters (LT8722ResponseEngine), which are driven 
+ *              sample by sample and can therefore also run against a model
+ *              of the plant.
+ *
+ * Notes: This code was written as part of my master's thesis at the
+ *        Institute for Microsensors, -actuators and -systems (IMSAS)
+ *        at the University of Bremen.
+ */
+
+#include "LT8722FrequencyResponse.h"
+
+/**************************************************************************/
+/*!
+    @brief Run the complete measurement on the LT8722. The AMUX is parked
+           on the response value and the setpoint and the analog output
+           are processed in lockstep with the sample rate.
+    @param device LT8722 to be measured
+    @param value Predefined value of the analog output used as response
+    @return Error (True) if an error accrued during the SPI communication,
+            no frequency is left to measure (begin() not called) or 
+            another owner holds the analog input
+*/
+/**************************************************************************/
+bool LT8722FrequencyResponse::measure(LT8722 *device, ANALOG_OUTPUT value) {
+    //nothing to measure, the device is left untouched
+    if (isComplete() || _sampleRate <= 0) {
+        return true;
+    }
+
+    //the line may be driven by another device with the same analog input
+    if (LT8722::lockAnalogInput(device->getAnalogInput(), this)) {
+        return true;
+    }
+
+    uint8_t analogInput = device->getAnalogInput();
+    uint32_t period = 1000000 / _sampleRate;
+    double reference = 0.0;
+    bool error = false;
+
+    //measure the reference once instead of for every sample
+    if (value == ANALOG_OUTPUT::VOLTAGE || value == ANALOG_OUTPUT::CURRENT) {
+        error |= device->parkAnalogOutput((value == ANALOG_OUTPUT::VOLTAGE) ? ANALOG_OUTPUT::REFERENCE_1_25 : ANALOG_OUTPUT::REFERENCE_1_65);
+        delay(10);
+        reference = analogReadMilliVolts(analogInput);
+        reference /= 1000;
+    }
+
+    error |= device->parkAnalogOutput(value);
+    delay(10);
+
+    uint32_t nextSample = micros();
+    while (!isComplete()) {
+        while ((int32_t)(micros() - nextSample) < 0) {
+        }
+        nextSample += period;
+
+        error |= device->setVoltage(next());
+
+        double voltage = analogReadMilliVolts(analogInput);
+        voltage /= 1000;
+        update(LT8722::convertAnalogOutput(value, voltage, reference));
+    }
+
+    error |= device->setVoltage(_offset);
+    error |= device->releaseAnalogOutput();
+    LT8722::unlockAnalogInput(device->getAnalogInput(), this);
+
+    return error;
+}
@@ -0,0 +1,40 @@
+/*
+ * File Name: LT8722FrequencyResponse.h
+ * Description: Measurement of the frequency response (gain and phase) of
+ *              the loop driven by the LT8722. A stepped sine is injected
+ *              through the output voltage and the response is sampled in
+ *              lockstep. Gain and phase are calculated incrementally with
+ *              Goertzel filters (LT8722ResponseEngine), which are driven 
+ *              sample by sample and can therefore also run against a model
+ *              of the plant.
+ *
+ * Notes: This code was written as part of my master's thesis at the
+ *        Institute for Microsensors, -actuators and -systems (IMSAS)
+ *        at the University of Bremen.
+ */
+
+#ifndef LT8722FREQUENCYRESPONSE_H
+#define LT8722FREQUENCYRESPONSE_H
+
+#include <Arduino.h>
+#include "LT8722.h"
+#include "LT8722ResponseEngine.h"
+
+class LT8722FrequencyResponse : public LT8722ResponseEngine {
+public:
+    /**************************************************************************/
+    /*!
+        @brief Run the complete measurement on the LT8722. The AMUX is parked
+               on the response value and the setpoint and the analog output
+               are processed in lockstep with the sample rate.
+        @param device LT8722 to be measured
+        @param value Predefined value of the analog output used as response
+        @return Error (True) if an error accrued during the SPI communication,
+                no frequency is left to measure (begin() not called) or 
+                another owner holds the analog input
+    */
+    /**************************************************************************/
+    bool measure(LT8722 *device, ANALOG_OUTPUT value);
+};
+
+#endif
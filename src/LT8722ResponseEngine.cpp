@@ -0,0 +1,204 @@
+/*
+ * File Name: LT8722ResponseEngine.cpp
+ * Description: Sample-driven engine of the frequency response measurement.
+ *              It generates the stepped sine setpoints and calculates gain
+ *              and phase incrementally with Goertzel filters, so only a
+ *              constant amount of memory per frequency is needed. It does
+ *              not depend on the Arduino core, so it can run against a
+ *              model of the plant on the host.
+ *
+ * Notes: This code was written as part of my master's thesis at the
+ *        Institute for Microsensors, -actuators and -systems (IMSAS)
+ *        at the University of Bremen.
+ */
+
+#include "LT8722ResponseEngine.h"
+
+#include <math.h>
+#include <stddef.h>
+
+/**************************************************************************/
+/*!
+    @brief Create the engine without frequencies
+*/
+/**************************************************************************/
+LT8722ResponseEngine::LT8722ResponseEngine() {
+    _frequencies = NULL;
+    _gain = NULL;
+    _phase = NULL;
+    _count = 0;
+    _index = 0;
+
+    _offset = 0.0;
+    _amplitude = 0.0;
+    _sampleRate = 0.0;
+    _settleCycles = 0;
+    _measureCycles = 0;
+}
+
+/**************************************************************************/
+/*!
+    @brief Define the excitation and the frequencies to be measured
+    @param frequencies Frequencies in Hz to be measured one after another
+    @param gain Output array for the gain of every frequency
+    @param phase Output array for the phase of every frequency in degrees
+    @param count Number of frequencies
+    @param offset Offset of the injected sine (output voltage)
+    @param amplitude Amplitude of the injected sine (output voltage)
+    @param sampleRate Sample rate in Hz
+    @param settleCycles Periods that are skipped after a frequency change
+    @param measureCycles Periods that are evaluated for every frequency
+*/
+/**************************************************************************/
+void LT8722ResponseEngine::begin(const double *frequencies, double *gain, double *phase, uint8_t count,
+                                    double offset, double amplitude, double sampleRate,
+                                    uint16_t settleCycles, uint16_t measureCycles) {
+    _frequencies = frequencies;
+    _gain = gain;
+    _phase = phase;
+    _count = count;
+    _index = 0;
+
+    _offset = offset;
+    _amplitude = amplitude;
+    _sampleRate = sampleRate;
+    _settleCycles = settleCycles;
+    _measureCycles = measureCycles;
+
+    if (_count > 0) {
+        startFrequency();
+    }
+}
+
+/**************************************************************************/
+/*!
+    @brief Calculate logarithmically spaced frequencies for a sweep
+    @param frequencies Output array for the frequencies
+    @param count Number of frequencies
+    @param start First frequency in Hz
+    @param stop Last frequency in Hz
+*/
+/**************************************************************************/
+void LT8722ResponseEngine::logSweep(double *frequencies, uint8_t count, double start, double stop) {
+    for (uint8_t i = 0; i < count; i++) {
+        double position = (count > 1) ? (double)i / (count - 1) : 0.0;
+        frequencies[i] = start * pow(stop / start, position);
+    }
+}
+
+/**************************************************************************/
+/*!
+    @brief Return the setpoint for the next sample
+    @return Output voltage to be set
+*/
+/**************************************************************************/
+double LT8722ResponseEngine::next() {
+    if (isComplete()) {
+        _input = 0.0;
+        return _offset;
+    }
+
+    _input = _amplitude * sin(_angle);
+
+    _angle += _omega;
+    if (_angle >= 2 * M_PI) {
+        _angle -= 2 * M_PI;
+    }
+
+    return _offset + _input;
+}
+
+/**************************************************************************/
+/*!
+    @brief Add the response belonging to the last setpoint of next()
+    @param response Measured response
+*/
+/**************************************************************************/
+void LT8722ResponseEngine::update(double response) {
+    if (isComplete()) {
+        return;
+    }
+
+    //mean of the response during the settling time, removed to avoid leakage of the offset
+    if (_sample < _settleSamples) {
+        _responseOffset += response / _settleSamples;
+    } else if (_settleSamples == 0 && _sample == 0) {
+        _responseOffset = response;
+    }
+
+    //Goertzel filters for the injected sine and the response
+    if (_sample >= _settleSamples) {
+        double input0 = _input + _coefficient * _input1 - _input2;
+        _input2 = _input1;
+        _input1 = input0;
+
+        double output0 = (response - _responseOffset) + _coefficient * _output1 - _output2;
+        _output2 = _output1;
+        _output1 = output0;
+    }
+    _sample++;
+
+    if (_sample < _settleSamples + _measureSamples) {
+        return;
+    }
+
+    //complex results of both filters, the ratio is the frequency response
+    double inputReal = _input1 - _input2 * cos(_omega);
+    double inputImag = _input2 * sin(_omega);
+    double outputReal = _output1 - _output2 * cos(_omega);
+    double outputImag = _output2 * sin(_omega);
+
+    double inputMagnitude = sqrt(inputReal * inputReal + inputImag * inputImag);
+    double outputMagnitude = sqrt(outputReal * outputReal + outputImag * outputImag);
+    double phase = (atan2(outputImag, outputReal) - atan2(inputImag, inputReal)) * 180 / M_PI;
+
+    if (phase > 180) {
+        phase -= 360;
+    } else if (phase <= -180) {
+        phase += 360;
+    }
+
+    _gain[_index] = (inputMagnitude > 0) ? outputMagnitude / inputMagnitude : 0.0;
+    _phase[_index] = phase;
+
+    _index++;
+    if (!isComplete()) {
+        startFrequency();
+    }
+}
+
+/**************************************************************************/
+/*!
+    @brief Return whether all frequencies have been measured
+    @return True if the measurement is complete
+*/
+/**************************************************************************/
+bool LT8722ResponseEngine::isComplete() {
+    return _index >= _count;
+}
+
+/**************************************************************************/
+/*!
+    @brief Prepare the Goertzel filters for the current frequency
+*/
+/**************************************************************************/
+void LT8722ResponseEngine::startFrequency() {
+    double frequency = _frequencies[_index];
+    double samplesPerCycle = _sampleRate / frequency;
+
+    _omega = 2 * M_PI * frequency / _sampleRate;
+    _coefficient = 2 * cos(_omega);
+    _angle = 0.0;
+    _sample = 0;
+    _settleSamples = _settleCycles * samplesPerCycle + 0.5;
+    _measureSamples = _measureCycles * samplesPerCycle + 0.5;
+    if (_measureSamples == 0) {
+        _measureSamples = 1;
+    }
+
+    _input1 = 0.0;
+    _input2 = 0.0;
+    _output1 = 0.0;
+    _output2 = 0.0;
+    _responseOffset = 0.0;
+}
@@ -0,0 +1,119 @@
+/*
+ * File Name: LT8722ResponseEngine.h
+ * Description: Sample-driven engine of the frequency response measurement.
+ *              It generates the stepped sine setpoints and calculates gain
+ *              and phase incrementally with Goertzel filters, so only a
+ *              constant amount of memory per frequency is needed. It does
+ *              not depend on the Arduino core, so it can run against a
+ *              model of the plant on the host.
+ *
+ * Notes: This code was written as part of my master's thesis at the
+ *        Institute for Microsensors, -actuators and -systems (IMSAS)
+ *        at the University of Bremen.
+ */
+
+#ifndef LT8722RESPONSEENGINE_H
+#define LT8722RESPONSEENGINE_H
+
+#include <stdint.h>
+
+class LT8722ResponseEngine {
+public:
+    /**************************************************************************/
+    /*!
+        @brief Create the engine without frequencies
+    */
+    /**************************************************************************/
+    LT8722ResponseEngine();
+
+    /**************************************************************************/
+    /*!
+        @brief Define the excitation and the frequencies to be measured
+        @param frequencies Frequencies in Hz to be measured one after another
+        @param gain Output array for the gain of every frequency
+        @param phase Output array for the phase of every frequency in degrees
+        @param count Number of frequencies
+        @param offset Offset of the injected sine (output voltage)
+        @param amplitude Amplitude of the injected sine (output voltage)
+        @param sampleRate Sample rate in Hz
+        @param settleCycles Periods that are skipped after a frequency change
+        @param measureCycles Periods that are evaluated for every frequency
+    */
+    /**************************************************************************/
+    void begin(const double *frequencies, double *gain, double *phase, uint8_t count,
+               double offset, double amplitude, double sampleRate,
+               uint16_t settleCycles = 2, uint16_t measureCycles = 4);
+
+    /**************************************************************************/
+    /*!
+        @brief Calculate logarithmically spaced frequencies for a sweep
+        @param frequencies Output array for the frequencies
+        @param count Number of frequencies
+        @param start First frequency in Hz
+        @param stop Last frequency in Hz
+    */
+    /**************************************************************************/
+    static void logSweep(double *frequencies, uint8_t count, double start, double stop);
+
+    /**************************************************************************/
+    /*!
+        @brief Return the setpoint for the next sample
+        @return Output voltage to be set
+    */
+    /**************************************************************************/
+    double next();
+
+    /**************************************************************************/
+    /*!
+        @brief Add the response belonging to the last setpoint of next()
+        @param response Measured response
+    */
+    /**************************************************************************/
+    void update(double response);
+
+    /**************************************************************************/
+    /*!
+        @brief Return whether all frequencies have been measured
+        @return True if the measurement is complete
+    */
+    /**************************************************************************/
+    bool isComplete();
+
+protected:
+    double _offset;
+    double _sampleRate;
+
+private:
+    /**************************************************************************/
+    /*!
+        @brief Prepare the Goertzel filters for the current frequency
+    */
+    /**************************************************************************/
+    void startFrequency();
+
+    const double *_frequencies;
+    double *_gain;
+    double *_phase;
+    uint8_t _count;
+    uint8_t _index;
+
+    double _amplitude;
+    uint16_t _settleCycles;
+    uint16_t _measureCycles;
+
+    double _omega;
+    double _angle;
+    double _coefficient;
+    double _input;
+    uint32_t _sample;
+    uint32_t _settleSamples;
+    uint32_t _measureSamples;
+
+    double _input1;
+    double _input2;
+    double _output1;
+    double _output2;
+    double _responseOffset;
+};
+
+#endif
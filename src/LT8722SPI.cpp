@@ -12,40 +12,241 @@
 
 #include "LT8722SPI.h"
 #include "CRC8.h"
+#include <soc/spi_struct.h>
+#include <esp_timer.h>
+
+#ifdef LT8722_FAULT_INJECTION
+#include "LT8722FaultInjection.h"
+#endif
 
 /**************************************************************************/
 /*!
-    @brief Read the status register
+    @brief Send a complete frame and receive the answer of the LT8722. With 
+           LT8722_USE_IRAM the frame is sent with transferFrameDirect(),
+           without the SPI bus lock and without functions in flash, so the
+           bus must not be shared with other tasks in this case. If the 
+           bus is not registered with attachFrameBus(), the received bytes 
+           are cleared, so the frame is not acknowledged. With 
+           LT8722_FAULT_INJECTION the received bytes pass through the 
+           fault injection.
     @param spi SPI object
     @param cs Chip select (sc) pin
-    @return dataSPI structure containing data, status,crc, ack and error
+    @param sendingPacket Bytes to be sent
+    @param receivedPacket Received bytes
+    @param length Length of the frame
+    @param start Output, time right before the chip select goes low in
+           microseconds (esp_timer_get_time()), NULL if not needed
 */
 /**************************************************************************/
-dataSPI readStatus(SPIClass* spi, uint8_t cs){
-  struct dataSPI dataPacket;
-
-  uint8_t command = 0xF0;                       //status acquisition command
-  uint8_t address = (0x01 << 1) & 0xFE;         //SPI_STATUS address A[7:1] 
-  uint8_t sendingPacket[] = {command, address};
-
+void LT8722_IRAM_ATTR transferFrame(SPIClass* spi, uint8_t cs, uint8_t *sendingPacket, uint8_t *receivedPacket, uint8_t length, int64_t *start) {
+#ifdef LT8722_USE_IRAM
+  if (transferFrameDirect(spi, cs, sendingPacket, receivedPacket, length, start)) {
+    //nothing was sent, an empty answer fails the acknowledge check instead of leaving stale bytes
+    for (uint8_t i = 0; i < length; i++) {
+      receivedPacket[i] = 0x00;
+    }
+  }
+#else
   spi->beginTransaction(SPISettings(4000000, MSBFIRST, SPI_MODE0));
+  if (start != NULL) {
+    *start = esp_timer_get_time();              //after the bus lock, which may have to be waited for
+  }
   digitalWrite(cs, LOW);
-  dataPacket.status[0] = spi->transfer((int8_t)sendingPacket[0]);
-  dataPacket.status[1] = spi->transfer((int8_t)sendingPacket[1]);
-  dataPacket.crc = spi->transfer((int8_t)getCRC2(sendingPacket));
-  dataPacket.ack = spi->transfer((int8_t)0x00);
+  spi->transferBytes(sendingPacket, receivedPacket, length);
   digitalWrite(cs, HIGH);
   spi->endTransaction();
+#endif
 
-  //fill dataPacket struct with empty data bytes 
-  for (uint8_t i = 0; i < 4; i++)
-  {
-    dataPacket.data[i] = (int8_t)0x00;
+#ifdef LT8722_FAULT_INJECTION
+  LT8722FaultInjection::process(cs, sendingPacket, receivedPacket, length);
+#endif
+}
+
+#if CONFIG_IDF_TARGET_ESP32C6 || CONFIG_IDF_TARGET_ESP32H2 || CONFIG_IDF_TARGET_ESP32P4
+#define FRAME_BUS_DATA(hw, i) ((hw)->data_buf[i].val)
+#else
+#define FRAME_BUS_DATA(hw, i) ((hw)->data_buf[i])
+#endif
+
+//SPI objects and the hardware of their buses, read from interrupts
+static spi_t *frameBusHandles[LT8722_FRAME_BUSES];
+static volatile spi_dev_t *frameBusDevices[LT8722_FRAME_BUSES];
+
+/**************************************************************************/
+/*!
+    @brief Return the hardware of a registered SPI bus
+    @param spi SPI object
+    @return SPI hardware (NULL if the bus is not registered)
+*/
+/**************************************************************************/
+static IRAM_ATTR volatile spi_dev_t* findFrameBus(SPIClass* spi) {
+  spi_t *bus = spi->bus();
+
+  for (uint8_t i = 0; i < LT8722_FRAME_BUSES; i++) {
+    if (frameBusHandles[i] == bus) {
+      return frameBusDevices[i];
+    }
   }
-  
+
+  return NULL;
+}
+
+/**************************************************************************/
+/*!
+    @brief Register the hardware of the SPI bus of an SPI object, so that
+           frames can be sent on it from interrupts with 
+           transferFrameDirect()
+    @param spi SPI object
+    @param spi_bus SPI type given to the SPI object (FSPI, HSPI, ...)
+    @return Error (True) if the bus is unknown or LT8722_FRAME_BUSES buses
+            are already registered
+*/
+/**************************************************************************/
+bool attachFrameBus(SPIClass* spi, uint8_t spi_bus) {
+  volatile spi_dev_t *hw = NULL;
+  spi_t *bus = spi->bus();
+
+#if CONFIG_IDF_TARGET_ESP32
+  if (spi_bus == 1) {
+    hw = &SPI1;
+  } else if (spi_bus == 2) {
+    hw = &SPI2;
+  } else if (spi_bus == 3) {
+    hw = &SPI3;
+  }
+#else
+  if (spi_bus == FSPI) {
+    hw = &GPSPI2;
+  }
+#if SOC_SPI_PERIPH_NUM > 2
+  if (spi_bus == HSPI) {
+    hw = &GPSPI3;
+  }
+#endif
+#endif
+
+  if (hw == NULL || bus == NULL) {
+    return true;
+  }
+
+  for (uint8_t i = 0; i < LT8722_FRAME_BUSES; i++) {
+    if (frameBusHandles[i] == bus) {
+      return false;
+    }
+    if (frameBusHandles[i] == NULL) {
+      frameBusDevices[i] = hw;      //hardware first, an interrupt must never find the bus without it
+      frameBusHandles[i] = bus;
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief Wait until the SPI hardware of a registered bus has finished 
+           the running transfer, e.g. one that was interrupted in the 
+           middle of a frame. Runs from IRAM.
+    @param spi SPI object registered with attachFrameBus()
+*/
+/**************************************************************************/
+void IRAM_ATTR waitFrameBus(SPIClass* spi) {
+  volatile spi_dev_t *hw = findFrameBus(spi);
+
+  if (hw != NULL) {
+    while (hw->cmd.usr);
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief Send a frame by writing the registers of the SPI hardware 
+           directly. Runs from IRAM without locks and without any function
+           of the Arduino core or in flash, so it can be used in interrupts 
+           and while the flash cache is disabled. The bus settings of the
+           last transaction are used.
+    @param spi SPI object registered with attachFrameBus()
+    @param cs Chip select (sc) pin
+    @param sendingPacket Bytes to be sent
+    @param receivedPacket Received bytes (NULL if not needed)
+    @param length Length of the frame (up to 64 bytes)
+    @param start Output, time right before the chip select goes low in
+           microseconds (esp_timer_get_time()), NULL if not needed
+    @return Error (True) if the bus is not registered or the frame is too
+            long
+*/
+/**************************************************************************/
+bool IRAM_ATTR transferFrameDirect(SPIClass* spi, uint8_t cs, const uint8_t *sendingPacket, uint8_t *receivedPacket, uint8_t length, int64_t *start) {
+  volatile spi_dev_t *hw = findFrameBus(spi);
+  uint8_t words = (length + 3) / 4;
+
+  if (hw == NULL || length == 0 || length > 64) {
+    return true;
+  }
+
+  //never change the buffer while the hardware still shifts it out
+  while (hw->cmd.usr);
+
+#if CONFIG_IDF_TARGET_ESP32
+  hw->mosi_dlen.usr_mosi_dbitlen = length * 8 - 1;
+  hw->miso_dlen.usr_miso_dbitlen = length * 8 - 1;
+#elif CONFIG_IDF_TARGET_ESP32S2
+  hw->mosi_dlen.usr_mosi_bit_len = length * 8 - 1;
+  hw->miso_dlen.usr_miso_bit_len = length * 8 - 1;
+#else
+  hw->ms_dlen.ms_data_bitlen = length * 8 - 1;
+#endif
+
+  //the first byte on the bus is the lowest byte of the first word
+  for (uint8_t i = 0; i < words; i++) {
+    uint32_t word = 0;
+    for (uint8_t j = 0; j < 4 && i * 4 + j < length; j++) {
+      word |= static_cast<uint32_t>(sendingPacket[i * 4 + j]) << (j * 8);
+    }
+    FRAME_BUS_DATA(hw, i) = word;
+  }
+
+  if (start != NULL) {
+    *start = esp_timer_get_time();
+  }
+  selectChip(cs);
+#if !CONFIG_IDF_TARGET_ESP32 && !CONFIG_IDF_TARGET_ESP32S2
+  hw->cmd.update = 1;
+  while (hw->cmd.update);
+#endif
+  hw->cmd.usr = 1;
+  while (hw->cmd.usr);
+  deselectChip(cs);
+
+  if (receivedPacket != NULL) {
+    for (uint8_t i = 0; i < words; i++) {
+      uint32_t word = FRAME_BUS_DATA(hw, i);
+      for (uint8_t j = 0; j < 4 && i * 4 + j < length; j++) {
+        receivedPacket[i * 4 + j] = word >> (j * 8);
+      }
+    }
+  }
+
+  return false;
+}
+
+/**************************************************************************/
+/*!
+    @brief Check the acknowledge and the CRC of a received frame and set its
+           error flag
+    @param dataPacket Received frame
+    @return Error (True) if the frame was not acknowledged or the CRC is 
+            wrong
+*/
+/**************************************************************************/
+bool LT8722_IRAM_ATTR validateFrame(dataSPI &dataPacket) {
+  //the CRC covers the status of a status or write frame and the status and data of a read frame
+  uint8_t length = (dataPacket.type == FRAME_TYPE::READ) ? 6 : 2;
+
   //check for crc errors
-  if (dataPacket.ack == 0xA5) {
-    if (checkCRC(dataPacket.status, dataPacket.data, 2, dataPacket.crc)) {
+  if (dataPacket.getAck() == 0xA5) {
+    if (checkCRC(dataPacket.frame, dataPacket.frame + 2, length, dataPacket.getCRC())) {
       dataPacket.error = false;
     } else {
       dataPacket.error = true;
@@ -53,6 +254,56 @@ dataSPI readStatus(SPIClass* spi, uint8_t cs){
   } else {
     dataPacket.error = true;
   }
+
+  return dataPacket.error;
+}
+
+/**************************************************************************/
+/*!
+    @brief Check the acknowledge and the CRC of several received frames in
+           one pass and set their error flags
+    @param dataPackets Array of received frames
+    @param count Number of frames
+    @return Number of frames with an error
+*/
+/**************************************************************************/
+uint16_t LT8722_IRAM_ATTR validateFrames(dataSPI *dataPackets, uint16_t count) {
+  uint16_t errors = 0;
+
+  for (uint16_t i = 0; i < count; i++) {
+    if (validateFrame(dataPackets[i])) {
+      errors++;
+    }
+  }
+
+  return errors;
+}
+
+/**************************************************************************/
+/*!
+    @brief Read the status register
+    @param spi SPI object
+    @param cs Chip select (sc) pin
+    @return dataSPI structure containing data, status,crc, ack and error
+*/
+/**************************************************************************/
+dataSPI LT8722_IRAM_ATTR readStatus(SPIClass* spi, uint8_t cs){
+  struct dataSPI dataPacket;
+
+  uint8_t command = 0xF0;                       //status acquisition command
+  uint8_t address = (0x01 << 1) & 0xFE;         //SPI_STATUS address A[7:1] 
+  uint8_t sendingPacket[] = {command, address, 0x00, 0x00};
+
+  sendingPacket[2] = getCRC2(sendingPacket);
+  dataPacket.type = FRAME_TYPE::STATUS;
+  transferFrame(spi, cs, sendingPacket, dataPacket.frame, 4);
+
+  //the bytes after the frame stay empty
+  for (uint8_t i = 4; i < 8; i++) {
+    dataPacket.frame[i] = 0x00;
+  }
+
+  validateFrame(dataPacket);
   
   return dataPacket;
 }
@@ -66,36 +317,18 @@ dataSPI readStatus(SPIClass* spi, uint8_t cs){
     @return dataSPI structure containing status, data, crc, ack and error
 */
 /**************************************************************************/
-dataSPI readRegister(SPIClass* spi, uint8_t cs, uint8_t address) {
+dataSPI LT8722_IRAM_ATTR readRegister(SPIClass* spi, uint8_t cs, uint8_t address) {
   struct dataSPI dataPacket;
 
   uint8_t command = 0xF4;                       //data read command
   address = (address << 1) & 0xFE;              //register address A[7:1] 
-  uint8_t sendingPacket[] = {command, address};
+  uint8_t sendingPacket[] = {command, address, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
 
-  spi->beginTransaction(SPISettings(4000000, MSBFIRST, SPI_MODE0));
-  digitalWrite(cs, LOW);
-  dataPacket.status[0] = spi->transfer((int8_t)sendingPacket[0]);
-  dataPacket.status[1] = spi->transfer((int8_t)sendingPacket[1]);
-  dataPacket.data[0] = spi->transfer((int8_t)getCRC2(sendingPacket));
-  dataPacket.data[1] = spi->transfer((int8_t)0x00);
-  dataPacket.data[2] = spi->transfer((int8_t)0x00);
-  dataPacket.data[3] = spi->transfer((int8_t)0x00);
-  dataPacket.crc = spi->transfer((int8_t)0x00);
-  dataPacket.ack = spi->transfer((int8_t)0x00);
-  digitalWrite(cs, HIGH);
-  spi->endTransaction();
+  sendingPacket[2] = getCRC2(sendingPacket);
+  dataPacket.type = FRAME_TYPE::READ;
+  transferFrame(spi, cs, sendingPacket, dataPacket.frame, 8);
 
-  //check for crc errors
-  if (dataPacket.ack == 0xA5) {
-    if (checkCRC(dataPacket.status, dataPacket.data, 6, dataPacket.crc)) {
-      dataPacket.error = false;
-    } else {
-      dataPacket.error = true;
-    }
-  } else {
-    dataPacket.error = true;
-  }
+  validateFrame(dataPacket);
   
   return dataPacket;
 }
@@ -110,36 +343,16 @@ dataSPI readRegister(SPIClass* spi, uint8_t cs, uint8_t address) {
     @return dataSPI structure containing status, data, crc, ack and error
 */
 /**************************************************************************/
-dataSPI writeRegister(SPIClass* spi, uint8_t cs, uint8_t address, uint8_t *data) {
+dataSPI LT8722_IRAM_ATTR writeRegister(SPIClass* spi, uint8_t cs, uint8_t address, uint8_t *data) {
   struct dataSPI dataPacket;
 
-  uint8_t command = 0xF2;                       //data write command
-  address = (address << 1) & 0xFE;              //register address A[7:1] 
-  uint8_t sendingPacket[] = {command, address};
+  uint8_t sendingPacket[8];
 
-  spi->beginTransaction(SPISettings(4000000, MSBFIRST, SPI_MODE0));
-  digitalWrite(cs, LOW);
-  dataPacket.status[0] = spi->transfer((int8_t)sendingPacket[0]);
-  dataPacket.status[1] = spi->transfer((int8_t)sendingPacket[1]);
-  dataPacket.crc = spi->transfer((int8_t)data[0]);
-  dataPacket.data[0] = spi->transfer((int8_t)data[1]);
-  dataPacket.data[1] = spi->transfer((int8_t)data[2]);
-  dataPacket.data[2] = spi->transfer((int8_t)data[3]);
-  dataPacket.data[3] = spi->transfer(getCRC6(sendingPacket, data));
-  dataPacket.ack = spi->transfer((int8_t)0x00);
-  digitalWrite(cs, HIGH);
-  spi->endTransaction();
+  encodeWriteFrame(address, data, sendingPacket);
+  dataPacket.type = FRAME_TYPE::WRITE;
+  transferFrame(spi, cs, sendingPacket, dataPacket.frame, 8);
 
-  //check for crc errors
-  if (dataPacket.ack == 0xA5) {
-    if (checkCRC(dataPacket.status, dataPacket.data, 2, dataPacket.crc)) {
-      dataPacket.error = false;
-    } else {
-      dataPacket.error = true;
-    }
-  } else {
-    dataPacket.error = true;
-  }
+  validateFrame(dataPacket);
   
   return dataPacket;
 }
@@ -154,13 +367,20 @@ dataSPI writeRegister(SPIClass* spi, uint8_t cs, uint8_t address, uint8_t *data)
     @param startBit First bit to be changed
     @param numBit Number of bits to be changed
     @param value DValue of the bits to be changed
-    @return dataSPI structure containing status, data, crc, ack and error
+    @param written Output, the four data bytes written to the register, 
+           NULL if not needed
+    @return dataSPI structure of the write frame (status, crc and ack), the
+            error covers the read and the write frame
 */
 /**************************************************************************/
-dataSPI changeBitsInRegister(SPIClass* spi, uint8_t cs, uint8_t address, uint8_t startBit, uint8_t numBits, uint8_t value) {
+dataSPI changeBitsInRegister(SPIClass* spi, uint8_t cs, uint8_t address, uint8_t startBit, uint8_t numBits, uint8_t value, uint8_t *written) {
   struct dataSPI dataPacket1 = readRegister(spi, cs, address);
+  uint8_t data[4];
+
+  //the received frame stays as received, so its CRC can still be checked
+  memcpy(data, dataPacket1.getDataBytes(), 4);
 
-  //change bits in dataPacket1 according to startBit, numBit and value
+  //change bits in the copy according to startBit, numBit and value
   for (uint8_t i = 0; i < numBits; i++) {
     uint8_t bitPosition = startBit + i;
     int byteIndex = 3 - (bitPosition / 8);
@@ -168,26 +388,30 @@ dataSPI changeBitsInRegister(SPIClass* spi, uint8_t cs, uint8_t address, uint8_t
     bool bitValue = (value >> i) & 0x01;
 
     if (bitValue) {
-      dataPacket1.data[byteIndex] |= (1 << bitOffset);
+      data[byteIndex] |= (1 << bitOffset);
     } else {
-      dataPacket1.data[byteIndex] &= ~(1 << bitOffset);
+      data[byteIndex] &= ~(1 << bitOffset);
     }
   }
 
-  struct dataSPI dataPacket2 = writeRegister(spi, cs, address, dataPacket1.data);
+  struct dataSPI dataPacket2 = writeRegister(spi, cs, address, data);
+
+  if (written != NULL) {
+    memcpy(written, data, 4);
+  }
 
   //check for crc errors
-  if (dataPacket1.ack == 0xA5 && dataPacket2.ack == 0xA5) {
+  if (dataPacket1.getAck() == 0xA5 && dataPacket2.getAck() == 0xA5) {
     if (!(dataPacket1.error || dataPacket2.error)) {
-      dataPacket1.error = false;
+      dataPacket2.error = false;
     } else {
-      dataPacket1.error = true;
+      dataPacket2.error = true;
     }
   } else {
-    dataPacket1.error = true;
+    dataPacket2.error = true;
   }
 
-  return dataPacket1;
+  return dataPacket2;
 }
 
 /**************************************************************************/
@@ -195,12 +419,14 @@ dataSPI changeBitsInRegister(SPIClass* spi, uint8_t cs, uint8_t address, uint8_t
     @brief Reset all registers apart from the status registers
     @param spi SPI object
     @param cs Chip select (sc) pin
-    @return dataSPI structure containing status, data, crc, ack and error
+    @param command Output, the four data bytes of the command register 
+           after the reset, NULL if not needed
+    @return dataSPI structure containing status, crc, ack and error
 */
 /**************************************************************************/
-dataSPI resetRegisters(SPIClass* spi, uint8_t cs) {
-  setCommandRegister(spi, cs, COMMAND_REG::SPI_RST, ENABLE);                              //set SPI_RST bit in command register to 1
-  struct dataSPI dataPacket = setCommandRegister(spi, cs, COMMAND_REG::SPI_RST, DISABLE); //set SPI_RST bit in command register to 0
+dataSPI resetRegisters(SPIClass* spi, uint8_t cs, uint8_t *command) {
+  setCommandRegister(spi, cs, COMMAND_REG::SPI_RST, ENABLE);                                       //set SPI_RST bit in command register to 1
+  struct dataSPI dataPacket = setCommandRegister(spi, cs, COMMAND_REG::SPI_RST, DISABLE, command); //set SPI_RST bit in command register to 0
 
   return dataPacket;
 }
@@ -229,10 +455,12 @@ dataSPI resetStatusRegister(SPIClass* spi, uint8_t cs) {
     @param cs Chip select (sc) pin
     @param symbol Symbol of the command register to be changed
     @param value New value for the symbol of the command register
-    @return dataSPI structure containing status, data, crc, ack and error
+    @param command Output, the four data bytes written to the command 
+           register, NULL if not needed
+    @return dataSPI structure containing status, crc, ack and error
 */
 /**************************************************************************/
-dataSPI setCommandRegister(SPIClass* spi, uint8_t cs, COMMAND_REG symbol, uint8_t value) {
+dataSPI setCommandRegister(SPIClass* spi, uint8_t cs, COMMAND_REG symbol, uint8_t value, uint8_t *command) {
   uint8_t regSymbol = static_cast<uint8_t>(symbol);
   struct dataSPI dataPacket;
 
@@ -240,33 +468,34 @@ dataSPI setCommandRegister(SPIClass* spi, uint8_t cs, COMMAND_REG symbol, uint8_
   switch (symbol)
   {
   case COMMAND_REG::ENABLE_REQ:
-    dataPacket = changeBitsInRegister(spi, cs, 0x00, regSymbol, 1, value); 
+    dataPacket = changeBitsInRegister(spi, cs, 0x00, regSymbol, 1, value, command); 
     break;
   case COMMAND_REG::SWEN_REQ:
-    dataPacket = changeBitsInRegister(spi, cs, 0x00, regSymbol, 1, value); 
+    dataPacket = changeBitsInRegister(spi, cs, 0x00, regSymbol, 1, value, command); 
     break;
   case COMMAND_REG::SW_FRQ_SET:
-    dataPacket = changeBitsInRegister(spi, cs, 0x00, regSymbol, 3, value); 
+    dataPacket = changeBitsInRegister(spi, cs, 0x00, regSymbol, 3, value, command); 
     break;
   case COMMAND_REG::SW_FRQ_ADJ:
-    dataPacket = changeBitsInRegister(spi, cs, 0x00, regSymbol, 2, value); 
+    dataPacket = changeBitsInRegister(spi, cs, 0x00, regSymbol, 2, value, command); 
     break;
   case COMMAND_REG::SYS_DC:
-    dataPacket = changeBitsInRegister(spi, cs, 0x00, regSymbol, 2, value); 
+    dataPacket = changeBitsInRegister(spi, cs, 0x00, regSymbol, 2, value, command); 
     break;
   case COMMAND_REG::VCC_VREG:
-    dataPacket = changeBitsInRegister(spi, cs, 0x00, regSymbol, 1, value); 
+    dataPacket = changeBitsInRegister(spi, cs, 0x00, regSymbol, 1, value, command); 
     break;
   case COMMAND_REG::SW_VC_INT:
-    dataPacket = changeBitsInRegister(spi, cs, 0x00, regSymbol, 3, value); 
+    dataPacket = changeBitsInRegister(spi, cs, 0x00, regSymbol, 3, value, command); 
     break;
   case COMMAND_REG::SPI_RST:
-    dataPacket = changeBitsInRegister(spi, cs, 0x00, regSymbol, 1, value); 
+    dataPacket = changeBitsInRegister(spi, cs, 0x00, regSymbol, 1, value, command); 
     break;
   case COMMAND_REG::PWR_LIM:
-    dataPacket = changeBitsInRegister(spi, cs, 0x00, regSymbol, 4, value); 
+    dataPacket = changeBitsInRegister(spi, cs, 0x00, regSymbol, 4, value, command); 
     break;
   default:
+    dataPacket.type = FRAME_TYPE::STATUS;
     dataPacket.error = 1;
     break;
   }
@@ -285,7 +514,6 @@ dataSPI setCommandRegister(SPIClass* spi, uint8_t cs, COMMAND_REG symbol, uint8_
 /**************************************************************************/
 dataSPI setOutputVoltage(SPIClass* spi, uint8_t cs, double voltage) {
   uint32_t registerValue = 0;
-  uint8_t data[4];
 
   //calculate needed register value to set the correct output voltage limit
   if (voltage >= 1.25) {
@@ -294,6 +522,21 @@ dataSPI setOutputVoltage(SPIClass* spi, uint8_t cs, double voltage) {
     registerValue = (voltage - 1.25) / -(2.5 * pow(2, -25));
   }
 
+  return setOutputVoltageRegister(spi, cs, registerValue);
+}
+
+/**************************************************************************/
+/*!
+    @brief Write an already calculated value to the SPIS_DAC register
+    @param spi SPI object
+    @param cs Chip select (sc) pin
+    @param registerValue Value of the SPIS_DAC register
+    @return dataSPI structure containing status, data, crc, ack and error
+*/
+/**************************************************************************/
+dataSPI LT8722_IRAM_ATTR setOutputVoltageRegister(SPIClass* spi, uint8_t cs, uint32_t registerValue) {
+  uint8_t data[4];
+
   //fill data array bit by bit with the new register value to set the output voltage
   for (uint8_t i = 0; i < 4; i++) {
     data[3 - i] = registerValue >> (i * 8);
@@ -15,6 +15,14 @@
 
 #include <Arduino.h>
 #include <SPI.h>
+#include <soc/gpio_reg.h>
+#include <soc/soc_caps.h>
+#include "LT8722Config.h"
+#include "LT8722Frame.h"
+
+#ifndef LT8722_FRAME_BUSES
+#define LT8722_FRAME_BUSES 4    //number of SPI buses that frames can be sent on from interrupts
+#endif
 
 enum class COMMAND_REG : uint8_t{
     ENABLE_REQ = 0,
@@ -31,16 +39,215 @@ enum class COMMAND_REG : uint8_t{
 #define DISABLE 0x00
 #define ENABLE  0x01
 
+enum class FRAME_TYPE : uint8_t{
+    STATUS = 0,     //status acquisition, 4 bytes: status, CRC, ack
+    READ   = 1,     //data read, 8 bytes: status, data, CRC, ack
+    WRITE  = 2,     //data write, 8 bytes: status, CRC, 4 bytes without meaning, ack
+};
+
 struct dataSPI {
-    uint8_t status[2];
-    uint8_t data[4];
-    uint8_t crc;
-    uint8_t ack;
+    uint8_t frame[8];                   //received bytes in the order of the bus
+    FRAME_TYPE type;
     bool error;
+
+    /**************************************************************************/
+    /*!
+        @brief Return the length of the frame
+        @return Number of bytes of the frame
+    */
+    /**************************************************************************/
+    constexpr uint8_t getLength() const {
+        return (type == FRAME_TYPE::STATUS) ? 4 : 8;
+    }
+
+    /**************************************************************************/
+    /*!
+        @brief Return the status register, bit [10-0]
+        @return Received status
+    */
+    /**************************************************************************/
+    constexpr uint16_t getStatus() const {
+        return (static_cast<uint16_t>(frame[0]) << 8) | frame[1];
+    }
+
+    /**************************************************************************/
+    /*!
+        @brief Return the position of the data bytes within the frame
+        @return Index of the first data byte
+    */
+    /**************************************************************************/
+    constexpr uint8_t getDataOffset() const {
+        return (type == FRAME_TYPE::READ) ? 2 : 3;
+    }
+
+    /**************************************************************************/
+    /*!
+        @brief Return the received data bytes as one word
+        @return Data of the frame (0 for a status frame)
+    */
+    /**************************************************************************/
+    constexpr uint32_t getData() const {
+        return (type == FRAME_TYPE::STATUS) ? 0 :
+            (static_cast<uint32_t>(frame[getDataOffset()]) << 24) |
+            (static_cast<uint32_t>(frame[getDataOffset() + 1]) << 16) |
+            (static_cast<uint32_t>(frame[getDataOffset() + 2]) << 8) |
+            frame[getDataOffset() + 3];
+    }
+
+    /**************************************************************************/
+    /*!
+        @brief Return the received CRC
+        @return CRC of the frame
+    */
+    /**************************************************************************/
+    constexpr uint8_t getCRC() const {
+        return (type == FRAME_TYPE::READ) ? frame[6] : frame[2];
+    }
+
+    /**************************************************************************/
+    /*!
+        @brief Return the received acknowledge
+        @return Acknowledge of the frame (0xA5 if the frame was accepted)
+    */
+    /**************************************************************************/
+    constexpr uint8_t getAck() const {
+        return frame[getLength() - 1];
+    }
+
+    /**************************************************************************/
+    /*!
+        @brief Return the data bytes within the frame without copying, a
+               change in place no longer matches the received CRC
+        @return Pointer to the first data byte
+    */
+    /**************************************************************************/
+    uint8_t *getDataBytes() {
+        return frame + getDataOffset();
+    }
 };
 
+//fast chip select functions without the overhead of digitalWrite
+
+/**************************************************************************/
+/*!
+    @brief Pull the chip select pin low by writing the GPIO register directly
+    @param cs Chip select (sc) pin
+*/
+/**************************************************************************/
+__attribute__((always_inline)) inline void selectChip(uint8_t cs) {
+#if SOC_GPIO_PIN_COUNT > 32
+  if (cs >= 32) {
+    REG_WRITE(GPIO_OUT1_W1TC_REG, 1UL << (cs - 32));
+    return;
+  }
+#endif
+  REG_WRITE(GPIO_OUT_W1TC_REG, 1UL << cs);
+}
+
+/**************************************************************************/
+/*!
+    @brief Pull the chip select pin high by writing the GPIO register directly
+    @param cs Chip select (sc) pin
+*/
+/**************************************************************************/
+__attribute__((always_inline)) inline void deselectChip(uint8_t cs) {
+#if SOC_GPIO_PIN_COUNT > 32
+  if (cs >= 32) {
+    REG_WRITE(GPIO_OUT1_W1TS_REG, 1UL << (cs - 32));
+    return;
+  }
+#endif
+  REG_WRITE(GPIO_OUT_W1TS_REG, 1UL << cs);
+}
+
 //basic functions for on register level communications
 
+/**************************************************************************/
+/*!
+    @brief Send a complete frame and receive the answer of the LT8722. With 
+           LT8722_USE_IRAM the frame is sent with transferFrameDirect(),
+           without the SPI bus lock and without functions in flash, so the
+           bus must not be shared with other tasks in this case. If the 
+           bus is not registered with attachFrameBus(), the received bytes 
+           are cleared, so the frame is not acknowledged. With 
+           LT8722_FAULT_INJECTION the received bytes pass through the 
+           fault injection.
+    @param spi SPI object
+    @param cs Chip select (sc) pin
+    @param sendingPacket Bytes to be sent
+    @param receivedPacket Received bytes
+    @param length Length of the frame
+    @param start Output, time right before the chip select goes low in
+           microseconds (esp_timer_get_time()), NULL if not needed
+*/
+/**************************************************************************/
+void transferFrame(SPIClass* spi, uint8_t cs, uint8_t *sendingPacket, uint8_t *receivedPacket, uint8_t length, int64_t *start = NULL);
+
+/**************************************************************************/
+/*!
+    @brief Register the hardware of the SPI bus of an SPI object, so that
+           frames can be sent on it from interrupts with 
+           transferFrameDirect()
+    @param spi SPI object
+    @param spi_bus SPI type given to the SPI object (FSPI, HSPI, ...)
+    @return Error (True) if the bus is unknown or LT8722_FRAME_BUSES buses
+            are already registered
+*/
+/**************************************************************************/
+bool attachFrameBus(SPIClass* spi, uint8_t spi_bus);
+
+/**************************************************************************/
+/*!
+    @brief Wait until the SPI hardware of a registered bus has finished 
+           the running transfer, e.g. one that was interrupted in the 
+           middle of a frame. Runs from IRAM.
+    @param spi SPI object registered with attachFrameBus()
+*/
+/**************************************************************************/
+void waitFrameBus(SPIClass* spi);
+
+/**************************************************************************/
+/*!
+    @brief Send a frame by writing the registers of the SPI hardware 
+           directly. Runs from IRAM without locks and without any function
+           of the Arduino core or in flash, so it can be used in interrupts 
+           and while the flash cache is disabled. The bus settings of the
+           last transaction are used.
+    @param spi SPI object registered with attachFrameBus()
+    @param cs Chip select (sc) pin
+    @param sendingPacket Bytes to be sent
+    @param receivedPacket Received bytes (NULL if not needed)
+    @param length Length of the frame (up to 64 bytes)
+    @param start Output, time right before the chip select goes low in
+           microseconds (esp_timer_get_time()), NULL if not needed
+    @return Error (True) if the bus is not registered or the frame is too
+            long
+*/
+/**************************************************************************/
+bool transferFrameDirect(SPIClass* spi, uint8_t cs, const uint8_t *sendingPacket, uint8_t *receivedPacket, uint8_t length, int64_t *start = NULL);
+
+/**************************************************************************/
+/*!
+    @brief Check the acknowledge and the CRC of a received frame and set its
+           error flag
+    @param dataPacket Received frame
+    @return Error (True) if the frame was not acknowledged or the CRC is 
+            wrong
+*/
+/**************************************************************************/
+bool validateFrame(dataSPI &dataPacket);
+
+/**************************************************************************/
+/*!
+    @brief Check the acknowledge and the CRC of several received frames in
+           one pass and set their error flags
+    @param dataPackets Array of received frames
+    @param count Number of frames
+    @return Number of frames with an error
+*/
+/**************************************************************************/
+uint16_t validateFrames(dataSPI *dataPackets, uint16_t count);
+
 /**************************************************************************/
 /*!
     @brief Read the status register
@@ -83,10 +290,13 @@ dataSPI writeRegister(SPIClass* spi, uint8_t cs, uint8_t address, uint8_t *data)
     @param startBit First bit to be changed
     @param numBit Number of bits to be changed
     @param value DValue of the bits to be changed
-    @return dataSPI structure containing status, data, crc, ack and error
+    @param written Output, the four data bytes written to the register, 
+           NULL if not needed
+    @return dataSPI structure of the write frame (status, crc and ack), the
+            error covers the read and the write frame
 */
 /**************************************************************************/
-dataSPI changeBitsInRegister(SPIClass* spi, uint8_t cs, uint8_t address, uint8_t startBit, uint8_t numBits, uint8_t value);
+dataSPI changeBitsInRegister(SPIClass* spi, uint8_t cs, uint8_t address, uint8_t startBit, uint8_t numBits, uint8_t value, uint8_t *written = NULL);
 
 //functions to reset specific registers
 
@@ -95,10 +305,12 @@ dataSPI changeBitsInRegister(SPIClass* spi, uint8_t cs, uint8_t address, uint8_t
     @brief Reset all registers apart from the status registers
     @param spi SPI object
     @param cs Chip select (sc) pin
-    @return dataSPI structure containing status, data, crc, ack and error
+    @param command Output, the four data bytes of the command register 
+           after the reset, NULL if not needed
+    @return dataSPI structure containing status, crc, ack and error
 */
 /**************************************************************************/
-dataSPI resetRegisters(SPIClass* spi, uint8_t cs);
+dataSPI resetRegisters(SPIClass* spi, uint8_t cs, uint8_t *command = NULL);
 
 /**************************************************************************/
 /*!
@@ -119,10 +331,12 @@ dataSPI resetStatusRegister(SPIClass* spi, uint8_t cs);
     @param cs Chip select (sc) pin
     @param symbol Symbol of the command register to be changed
     @param value New value for the symbol of the command register
-    @return dataSPI structure containing status, data, crc, ack and error
+    @param command Output, the four data bytes written to the command 
+           register, NULL if not needed
+    @return dataSPI structure containing status, crc, ack and error
 */
 /**************************************************************************/
-dataSPI setCommandRegister(SPIClass* spi, uint8_t cs, COMMAND_REG symbol, uint8_t value);
+dataSPI setCommandRegister(SPIClass* spi, uint8_t cs, COMMAND_REG symbol, uint8_t value, uint8_t *command = NULL);
 
 /**************************************************************************/
 /*!
@@ -135,6 +349,17 @@ dataSPI setCommandRegister(SPIClass* spi, uint8_t cs, COMMAND_REG symbol, uint8_
 /**************************************************************************/
 dataSPI setOutputVoltage(SPIClass* spi, uint8_t cs, double voltage);
 
+/**************************************************************************/
+/*!
+    @brief Write an already calculated value to the SPIS_DAC register
+    @param spi SPI object
+    @param cs Chip select (sc) pin
+    @param registerValue Value of the SPIS_DAC register
+    @return dataSPI structure containing status, data, crc, ack and error
+*/
+/**************************************************************************/
+dataSPI setOutputVoltageRegister(SPIClass* spi, uint8_t cs, uint32_t registerValue);
+
 /**************************************************************************/
 /*!
     @brief Ramp the output voltage from a start value to an end value in a 
@@ -0,0 +1,263 @@
+/*
+ * File Name: LT8722SampleRing.cpp
+ * Description: Ring buffer with pre- and post-trigger handling for the
+ *              captures of the analog output of the LT8722. The samples are
+ *              kept in a buffer given by the user (e.g. in PSRAM) and the
+ *              trigger is evaluated on every sample. Does not depend on the
+ *              Arduino core or ESP-IDF, so it is also checked on the host.
+ *
+ * Notes: This code was written as part of my master's thesis at the
+ *        Institute for Microsensors, -actuators and -systems (IMSAS)
+ *        at the University of Bremen.
+ */
+
+#include "LT8722SampleRing.h"
+
+#include <stddef.h>
+
+/**************************************************************************/
+/*!
+    @brief Create the ring buffer object without a buffer
+*/
+/**************************************************************************/
+LT8722SampleRing::LT8722SampleRing() {
+    _buffer = NULL;
+    _size = 0;
+    _pretrigger = 0;
+    _head = 0;
+    _written = 0;
+    _before = 0;
+    _after = 0;
+    _threshold = 0;
+    _lastSample = 0;
+    _manualTrigger = false;
+    _type = CAPTURE_TRIGGER::MANUAL;
+    _state = CAPTURE_STATE::IDLE;
+}
+
+/**************************************************************************/
+/*!
+    @brief Assign the buffer of the ring
+    @param buffer Buffer for the samples
+    @param size Number of samples of the buffer (one capture)
+    @param pretrigger Number of samples to be kept before the trigger
+    @return Error (True) if the buffer is NULL or its size is zero
+*/
+/**************************************************************************/
+bool LT8722SampleRing::begin(uint16_t *buffer, uint32_t size, uint32_t pretrigger) {
+    _state = CAPTURE_STATE::IDLE;
+    _head = 0;
+    _written = 0;
+    _before = 0;
+    _after = 0;
+
+    if (buffer == NULL || size == 0) {
+        _buffer = NULL;
+        _size = 0;
+        _pretrigger = 0;
+        return true;
+    }
+
+    _buffer = buffer;
+    _size = size;
+    _pretrigger = (pretrigger < size) ? pretrigger : size - 1;
+
+    return false;
+}
+
+/**************************************************************************/
+/*!
+    @brief Define the trigger of the capture
+    @param type Predefined trigger type
+    @param threshold Threshold in millivolts for RISING_EDGE and FALLING_EDGE
+*/
+/**************************************************************************/
+void LT8722SampleRing::setTrigger(CAPTURE_TRIGGER type, uint16_t threshold) {
+    _type = type;
+    _threshold = threshold;
+}
+
+/**************************************************************************/
+/*!
+    @brief Discard the samples and wait for the trigger
+    @return Error (True) if no buffer is assigned
+*/
+/**************************************************************************/
+bool LT8722SampleRing::arm() {
+    if (_size == 0) {
+        return true;
+    }
+
+    _head = 0;
+    _written = 0;
+    _before = 0;
+    _after = 0;
+    _manualTrigger = false;
+    _state = CAPTURE_STATE::ARMED;
+
+    return false;
+}
+
+/**************************************************************************/
+/*!
+    @brief Add samples and evaluate the trigger
+    @param samples Samples in millivolts
+    @param count Number of samples
+*/
+/**************************************************************************/
+void LT8722SampleRing::push(const uint16_t *samples, uint32_t count) {
+    for (uint32_t i = 0; i < count; i++) {
+        uint16_t sample = samples[i];
+
+        if (_state == CAPTURE_STATE::ARMED) {
+            bool fire = _manualTrigger;
+
+            if (_written > 0 && _type == CAPTURE_TRIGGER::RISING_EDGE) {
+                fire |= (_lastSample < _threshold && sample >= _threshold);
+            } else if (_written > 0 && _type == CAPTURE_TRIGGER::FALLING_EDGE) {
+                fire |= (_lastSample > _threshold && sample <= _threshold);
+            }
+
+            //keep as many pre-trigger samples as already recorded
+            if (fire) {
+                _manualTrigger = false;
+                _before = (_written < _pretrigger) ? _written : _pretrigger;
+                _after = 0;
+                _state = CAPTURE_STATE::TRIGGERED;
+            }
+        } else if (_state != CAPTURE_STATE::TRIGGERED) {
+            return;
+        }
+
+        _buffer[_head] = sample;
+        _head++;
+        if (_head == _size) {
+            _head = 0;
+        }
+        _written++;
+        _lastSample = sample;
+
+        if (_state == CAPTURE_STATE::TRIGGERED) {
+            _after++;
+            if (_before + _after >= _size) {
+                _state = CAPTURE_STATE::COMPLETE;
+            }
+        }
+    }
+}
+
+/**************************************************************************/
+/*!
+    @brief Trigger the capture with the next sample
+*/
+/**************************************************************************/
+void LT8722SampleRing::trigger() {
+    _manualTrigger = true;
+}
+
+/**************************************************************************/
+/*!
+    @brief Stop waiting for samples, a complete capture is kept
+*/
+/**************************************************************************/
+void LT8722SampleRing::stop() {
+    if (_state != CAPTURE_STATE::COMPLETE) {
+        _state = CAPTURE_STATE::IDLE;
+    }
+}
+
+/**************************************************************************/
+/*!
+    @brief Return the state of the capture
+    @return Predefined capture state
+*/
+/**************************************************************************/
+CAPTURE_STATE LT8722SampleRing::getState() {
+    return _state;
+}
+
+/**************************************************************************/
+/*!
+    @brief Return the trigger type
+    @return Predefined trigger type
+*/
+/**************************************************************************/
+CAPTURE_TRIGGER LT8722SampleRing::getTrigger() {
+    return _type;
+}
+
+/**************************************************************************/
+/*!
+    @brief Copy the captured samples in chronological order
+    @param output Output array for the samples in millivolts
+    @param count Maximum number of samples to be copied
+    @return Number of copied samples
+*/
+/**************************************************************************/
+uint32_t LT8722SampleRing::read(uint16_t *output, uint32_t count) {
+    const uint16_t *first;
+    const uint16_t *second;
+    uint32_t firstCount;
+    uint32_t secondCount;
+    uint32_t copied = 0;
+
+    getBlocks(first, firstCount, second, secondCount);
+
+    for (uint32_t i = 0; i < firstCount && copied < count; i++) {
+        output[copied++] = first[i];
+    }
+    for (uint32_t i = 0; i < secondCount && copied < count; i++) {
+        output[copied++] = second[i];
+    }
+
+    return copied;
+}
+
+/**************************************************************************/
+/*!
+    @brief Return the number of captured samples
+    @return Samples before and after the trigger
+*/
+/**************************************************************************/
+uint32_t LT8722SampleRing::getCaptured() {
+    return _before + _after;
+}
+
+/**************************************************************************/
+/*!
+    @brief Return the number of samples before the trigger
+    @return Index of the trigger sample in the capture
+*/
+/**************************************************************************/
+uint32_t LT8722SampleRing::getPretrigger() {
+    return _before;
+}
+
+/**************************************************************************/
+/*!
+    @brief Return the captured samples as (at most) two contiguous
+           blocks of the buffer in chronological order
+    @param first Output, first block
+    @param firstCount Output, number of samples of the first block
+    @param second Output, second block (the start of the buffer)
+    @param secondCount Output, number of samples of the second block
+*/
+/**************************************************************************/
+void LT8722SampleRing::getBlocks(const uint16_t *&first, uint32_t &firstCount, const uint16_t *&second, uint32_t &secondCount) {
+    uint32_t captured = _before + _after;
+
+    first = _buffer;
+    second = _buffer;
+    firstCount = 0;
+    secondCount = 0;
+
+    //without a buffer nothing was captured, so there is no division by zero
+    if (_size == 0 || captured == 0) {
+        return;
+    }
+
+    uint32_t start = (_head + _size - captured) % _size;
+    first = _buffer + start;
+    firstCount = (start + captured > _size) ? _size - start : captured;
+    secondCount = captured - firstCount;
+}
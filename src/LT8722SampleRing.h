@@ -0,0 +1,162 @@
+/*
+ * File Name: LT8722SampleRing.h
+ * Description: Ring buffer with pre- and post-trigger handling for the
+ *              captures of the analog output of the LT8722. The samples are
+ *              kept in a buffer given by the user (e.g. in PSRAM) and the
+ *              trigger is evaluated on every sample. Does not depend on the
+ *              Arduino core or ESP-IDF, so it is also checked on the host.
+ *
+ * Notes: This code was written as part of my master's thesis at the
+ *        Institute for Microsensors, -actuators and -systems (IMSAS)
+ *        at the University of Bremen.
+ */
+
+#ifndef LT8722SAMPLERING_H
+#define LT8722SAMPLERING_H
+
+#include <stdint.h>
+
+enum class CAPTURE_TRIGGER : uint8_t{
+    MANUAL        = 0x00,
+    RISING_EDGE   = 0x01,
+    FALLING_EDGE  = 0x02,
+    STATUS_CHANGE = 0x03
+};
+
+enum class CAPTURE_STATE : uint8_t{
+    IDLE      = 0x00,
+    ARMED     = 0x01,
+    TRIGGERED = 0x02,
+    COMPLETE  = 0x03
+};
+
+class LT8722SampleRing {
+public:
+    /**************************************************************************/
+    /*!
+        @brief Create the ring buffer object without a buffer
+    */
+    /**************************************************************************/
+    LT8722SampleRing();
+
+    /**************************************************************************/
+    /*!
+        @brief Assign the buffer of the ring
+        @param buffer Buffer for the samples
+        @param size Number of samples of the buffer (one capture)
+        @param pretrigger Number of samples to be kept before the trigger
+        @return Error (True) if the buffer is NULL or its size is zero
+    */
+    /**************************************************************************/
+    bool begin(uint16_t *buffer, uint32_t size, uint32_t pretrigger);
+
+    /**************************************************************************/
+    /*!
+        @brief Define the trigger of the capture
+        @param type Predefined trigger type
+        @param threshold Threshold in millivolts for RISING_EDGE and FALLING_EDGE
+    */
+    /**************************************************************************/
+    void setTrigger(CAPTURE_TRIGGER type, uint16_t threshold = 0);
+
+    /**************************************************************************/
+    /*!
+        @brief Discard the samples and wait for the trigger
+        @return Error (True) if no buffer is assigned
+    */
+    /**************************************************************************/
+    bool arm();
+
+    /**************************************************************************/
+    /*!
+        @brief Add samples and evaluate the trigger
+        @param samples Samples in millivolts
+        @param count Number of samples
+    */
+    /**************************************************************************/
+    void push(const uint16_t *samples, uint32_t count);
+
+    /**************************************************************************/
+    /*!
+        @brief Trigger the capture with the next sample
+    */
+    /**************************************************************************/
+    void trigger();
+
+    /**************************************************************************/
+    /*!
+        @brief Stop waiting for samples, a complete capture is kept
+    */
+    /**************************************************************************/
+    void stop();
+
+    /**************************************************************************/
+    /*!
+        @brief Return the state of the capture
+        @return Predefined capture state
+    */
+    /**************************************************************************/
+    CAPTURE_STATE getState();
+
+    /**************************************************************************/
+    /*!
+        @brief Return the trigger type
+        @return Predefined trigger type
+    */
+    /**************************************************************************/
+    CAPTURE_TRIGGER getTrigger();
+
+    /**************************************************************************/
+    /*!
+        @brief Copy the captured samples in chronological order
+        @param output Output array for the samples in millivolts
+        @param count Maximum number of samples to be copied
+        @return Number of copied samples
+    */
+    /**************************************************************************/
+    uint32_t read(uint16_t *output, uint32_t count);
+
+    /**************************************************************************/
+    /*!
+        @brief Return the number of captured samples
+        @return Samples before and after the trigger
+    */
+    /**************************************************************************/
+    uint32_t getCaptured();
+
+    /**************************************************************************/
+    /*!
+        @brief Return the number of samples before the trigger
+        @return Index of the trigger sample in the capture
+    */
+    /**************************************************************************/
+    uint32_t getPretrigger();
+
+    /**************************************************************************/
+    /*!
+        @brief Return the captured samples as (at most) two contiguous
+               blocks of the buffer in chronological order
+        @param first Output, first block
+        @param firstCount Output, number of samples of the first block
+        @param second Output, second block (the start of the buffer)
+        @param secondCount Output, number of samples of the second block
+    */
+    /**************************************************************************/
+    void getBlocks(const uint16_t *&first, uint32_t &firstCount, const uint16_t *&second, uint32_t &secondCount);
+
+private:
+    uint16_t *_buffer;
+    uint32_t _size;
+    uint32_t _pretrigger;
+    uint32_t _head;
+    uint32_t _written;
+    uint32_t _before;
+    uint32_t _after;
+    uint16_t _threshold;
+    uint16_t _lastSample;
+    volatile bool _manualTrigger;
+    CAPTURE_TRIGGER _type;
+    CAPTURE_STATE _state;
+};
+
+#endif
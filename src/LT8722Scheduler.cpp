@@ -0,0 +1,393 @@
+/*
+ * File Name: LT8722Scheduler.cpp
+ * Description: Timestamped setpoints for several LT8722. Setpoints are
+ *              queued with the time at which they have to be applied and
+ *              encoded into write frames of the SPIS_DAC register already
+ *              when they are queued. One high-resolution timer (esp_timer)
+ *              serves the queue of all devices: it fires shortly before
+ *              the earliest setpoint, waits for the exact time and sends
+ *              the frame. The difference between the scheduled and the
+ *              actual time is recorded for every setpoint.
+ *
+ * Notes: This code was written as part of my master's thesis at the
+ *        Institute for Microsensors, -actuators and -systems (IMSAS)
+ *        at the University of Bremen.
+ */
+
+#include "LT8722Scheduler.h"
+
+#if __has_include(<esp_timer.h>)
+
+/**************************************************************************/
+/*!
+    @brief Create the scheduler object
+*/
+/**************************************************************************/
+LT8722Scheduler::LT8722Scheduler() {
+    _count = 0;
+    _pending = 0;
+    _sequence = 0;
+    _timer = NULL;
+    portMUX_INITIALIZE(&_lock);
+
+    _issued = 0;
+    _failed = 0;
+    _maxError = 0;
+    _errorSum = 0;
+
+    for (uint8_t i = 0; i < LT8722_SCHEDULER_MAX_DEVICES; i++) {
+        _devices[i] = NULL;
+    }
+}
+
+/**************************************************************************/
+/*!
+    @brief Create the timer that serves the setpoints of all devices
+    @param devices Array of LT8722 objects (begin() already called)
+    @param count Number of devices
+    @return Error (True) if the number of devices is not supported or
+            the timer could not be created
+*/
+/**************************************************************************/
+bool LT8722Scheduler::begin(LT8722* devices[], uint8_t count) {
+    if (count == 0 || count > LT8722_SCHEDULER_MAX_DEVICES) {
+        return true;
+    }
+
+    for (uint8_t i = 0; i < count; i++) {
+        _devices[i] = devices[i];
+    }
+    _count = count;
+
+    if (_timer == NULL) {
+        esp_timer_create_args_t args = {};
+        args.callback = timerCallback;
+        args.arg = this;
+        args.dispatch_method = ESP_TIMER_TASK;
+        args.name = "LT8722Scheduler";
+
+        if (esp_timer_create(&args, &_timer) != ESP_OK) {
+            _timer = NULL;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**************************************************************************/
+/*!
+    @brief Queue a setpoint for a device, the write frame is encoded
+           immediately. A setpoint in the past is sent as soon as
+           possible and counts as late.
+    @param index Index of the device in the array passed to begin()
+    @param time Time of the setpoint in microseconds (esp_timer_get_time())
+    @param code Register value from voltageCode()
+    @return Error (True) if the index is invalid or the queue is full
+*/
+/**************************************************************************/
+bool LT8722Scheduler::schedule(uint8_t index, int64_t time, LT8722::VoltageCode code) {
+    if (index >= _count || _timer == NULL) {
+        return true;
+    }
+
+    LT8722ScheduledSetpoint entry;
+    uint8_t data[4];
+
+    //fill data array byte by byte with the register value
+    for (uint8_t i = 0; i < 4; i++) {
+        data[3 - i] = code.value >> (i * 8);
+    }
+
+    entry.time = time;
+    entry.code = code.value;
+    entry.device = index;
+    encodeWriteFrame(0x04, data, entry.frame);
+
+    portENTER_CRITICAL(&_lock);
+
+    if (_pending >= LT8722_SCHEDULER_MAX_ENTRIES) {
+        portEXIT_CRITICAL(&_lock);
+        return true;
+    }
+
+    entry.sequence = _sequence++;
+
+    //sift up
+    uint8_t position = _pending++;
+    _heap[position] = entry;
+    while (position > 0) {
+        uint8_t parent = (position - 1) / 2;
+        if (!earlier(position, parent)) {
+            break;
+        }
+        LT8722ScheduledSetpoint swap = _heap[parent];
+        _heap[parent] = _heap[position];
+        _heap[position] = swap;
+        position = parent;
+    }
+
+    portEXIT_CRITICAL(&_lock);
+
+    //only a new earliest setpoint changes the timer
+    if (position == 0) {
+        arm();
+    }
+
+    return false;
+}
+
+/**************************************************************************/
+/*!
+    @brief Remove all queued setpoints
+*/
+/**************************************************************************/
+void LT8722Scheduler::clear() {
+    //the timer may still fire once, it finds the queue empty
+    portENTER_CRITICAL(&_lock);
+    _pending = 0;
+    portEXIT_CRITICAL(&_lock);
+}
+
+/**************************************************************************/
+/*!
+    @brief Remove all queued setpoints and delete the timer
+*/
+/**************************************************************************/
+void LT8722Scheduler::end() {
+    clear();
+
+    if (_timer != NULL) {
+        esp_timer_stop(_timer);
+        esp_timer_delete(_timer);
+        _timer = NULL;
+    }
+    _count = 0;
+}
+
+/**************************************************************************/
+/*!
+    @brief Return the number of queued setpoints of all devices
+    @return Number of queued setpoints
+*/
+/**************************************************************************/
+uint8_t LT8722Scheduler::getPending() {
+    return _pending;
+}
+
+/**************************************************************************/
+/*!
+    @brief Return the current time of the timer used for scheduling
+    @return Time in microseconds
+*/
+/**************************************************************************/
+int64_t LT8722Scheduler::getTime() {
+    return esp_timer_get_time();
+}
+
+/**************************************************************************/
+/*!
+    @brief Return the number of setpoints sent since the last reset of
+           the statistics
+    @return Number of sent setpoints
+*/
+/**************************************************************************/
+uint32_t LT8722Scheduler::getIssued() {
+    return _issued;
+}
+
+/**************************************************************************/
+/*!
+    @brief Return the number of setpoints with an SPI error since the
+           last reset of the statistics
+    @return Number of failed setpoints
+*/
+/**************************************************************************/
+uint32_t LT8722Scheduler::getFailed() {
+    return _failed;
+}
+
+/**************************************************************************/
+/*!
+    @brief Return the mean difference between the scheduled time and the
+           falling chip select of the frame
+    @return Mean issue-time error in microseconds
+*/
+/**************************************************************************/
+double LT8722Scheduler::getMeanError() {
+    portENTER_CRITICAL(&_lock);
+    uint64_t errorSum = _errorSum;
+    uint32_t issued = _issued;
+    portEXIT_CRITICAL(&_lock);
+
+    if (issued == 0) {
+        return 0.0;
+    }
+    return static_cast<double>(errorSum) / issued;
+}
+
+/**************************************************************************/
+/*!
+    @brief Return the largest difference between the scheduled time and
+           the falling chip select of the frame
+    @return Maximum issue-time error in microseconds
+*/
+/**************************************************************************/
+uint32_t LT8722Scheduler::getMaxError() {
+    return _maxError;
+}
+
+/**************************************************************************/
+/*!
+    @brief Reset the number of setpoints and the issue-time errors
+*/
+/**************************************************************************/
+void LT8722Scheduler::resetStatistics() {
+    portENTER_CRITICAL(&_lock);
+    _issued = 0;
+    _failed = 0;
+    _maxError = 0;
+    _errorSum = 0;
+    portEXIT_CRITICAL(&_lock);
+}
+
+/**************************************************************************/
+/*!
+    @brief Callback of the timer, forwards to service()
+    @param context Scheduler object
+*/
+/**************************************************************************/
+void LT8722Scheduler::timerCallback(void *context) {
+    static_cast<LT8722Scheduler*>(context)->service();
+}
+
+/**************************************************************************/
+/*!
+    @brief Send every setpoint that is due within the lead time and arm
+           the timer for the next one
+*/
+/**************************************************************************/
+void LT8722Scheduler::service() {
+    while (true) {
+        LT8722ScheduledSetpoint entry;
+
+        portENTER_CRITICAL(&_lock);
+        if (_pending == 0) {
+            portEXIT_CRITICAL(&_lock);
+            return;
+        }
+        if (_heap[0].time - esp_timer_get_time() > LT8722_SCHEDULER_LEAD_US) {
+            portEXIT_CRITICAL(&_lock);
+            arm();
+            return;
+        }
+        pop(entry);
+        portEXIT_CRITICAL(&_lock);
+
+        //the timer fires early, the exact time is awaited by polling
+        while (esp_timer_get_time() < entry.time);
+
+        //the issue time is taken right before the chip select edge
+        int64_t start = entry.time;
+        bool error = _devices[entry.device]->setVoltageFrame(entry.frame, entry.code, &start);
+        uint32_t issueError = static_cast<uint32_t>(start - entry.time);
+
+        portENTER_CRITICAL(&_lock);
+        _issued = _issued + 1;
+        if (error) {
+            _failed = _failed + 1;
+        }
+        if (issueError > _maxError) {
+            _maxError = issueError;
+        }
+        _errorSum += issueError;
+        portEXIT_CRITICAL(&_lock);
+    }
+}
+
+/**************************************************************************/
+/*!
+    @brief Arm the timer for the earliest setpoint, has to be called
+           without the lock held. The earliest setpoint is read again
+           after the timer was started, so a setpoint queued in the
+           meantime is not missed.
+*/
+/**************************************************************************/
+void LT8722Scheduler::arm() {
+    int64_t armed = 0;
+    bool started = false;
+
+    while (true) {
+        portENTER_CRITICAL(&_lock);
+        bool pending = _pending > 0;
+        int64_t time = pending ? _heap[0].time : 0;
+        portEXIT_CRITICAL(&_lock);
+
+        //done when the timer is armed for the setpoint that is still the earliest
+        if (!pending || (started && time == armed)) {
+            return;
+        }
+
+        int64_t delay = time - LT8722_SCHEDULER_LEAD_US - esp_timer_get_time();
+        if (delay < 0) {
+            delay = 0;
+        }
+
+        esp_timer_stop(_timer);
+        esp_timer_start_once(_timer, static_cast<uint64_t>(delay));
+        armed = time;
+        started = true;
+    }
+}
+
+/**************************************************************************/
+/*!
+    @brief Compare two setpoints by time and sequence
+    @param a Index of the first setpoint in the heap
+    @param b Index of the second setpoint in the heap
+    @return True if the first setpoint is due before the second one
+*/
+/**************************************************************************/
+bool LT8722Scheduler::earlier(uint8_t a, uint8_t b) {
+    if (_heap[a].time != _heap[b].time) {
+        return _heap[a].time < _heap[b].time;
+    }
+    return static_cast<int32_t>(_heap[a].sequence - _heap[b].sequence) < 0;
+}
+
+/**************************************************************************/
+/*!
+    @brief Remove the earliest setpoint from the heap, has to be called
+           with the lock held
+    @param entry Removed setpoint
+*/
+/**************************************************************************/
+void LT8722Scheduler::pop(LT8722ScheduledSetpoint &entry) {
+    entry = _heap[0];
+    _heap[0] = _heap[--_pending];
+
+    //sift down
+    uint8_t position = 0;
+    while (true) {
+        uint8_t smallest = position;
+        uint8_t left = 2 * position + 1;
+        uint8_t right = left + 1;
+
+        if (left < _pending && earlier(left, smallest)) {
+            smallest = left;
+        }
+        if (right < _pending && earlier(right, smallest)) {
+            smallest = right;
+        }
+        if (smallest == position) {
+            break;
+        }
+
+        LT8722ScheduledSetpoint swap = _heap[smallest];
+        _heap[smallest] = _heap[position];
+        _heap[position] = swap;
+        position = smallest;
+    }
+}
+
+#endif
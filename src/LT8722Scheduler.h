@@ -0,0 +1,216 @@
+/*
+ * File Name: LT8722Scheduler.h
+ * Description: Timestamped setpoints for several LT8722. Setpoints are
+ *              queued with the time at which they have to be applied and
+ *              encoded into write frames of the SPIS_DAC register already
+ *              when they are queued. One high-resolution timer (esp_timer)
+ *              serves the queue of all devices: it fires shortly before
+ *              the earliest setpoint, waits for the exact time and sends
+ *              the frame. The difference between the scheduled and the
+ *              actual time is recorded for every setpoint.
+ *
+ * Notes: This code was written as part of my master's thesis at the
+ *        Institute for Microsensors, -actuators and -systems (IMSAS)
+ *        at the University of Bremen.
+ */
+
+#ifndef LT8722SCHEDULER_H
+#define LT8722SCHEDULER_H
+
+#include <Arduino.h>
+
+#if __has_include(<esp_timer.h>)
+#include <esp_timer.h>
+#include "LT8722.h"
+#include "LT8722SPI.h"
+
+#ifndef LT8722_SCHEDULER_MAX_DEVICES
+#define LT8722_SCHEDULER_MAX_DEVICES 16
+#endif
+
+#ifndef LT8722_SCHEDULER_MAX_ENTRIES
+#define LT8722_SCHEDULER_MAX_ENTRIES 64     //setpoints queued for all devices together
+#endif
+
+#ifndef LT8722_SCHEDULER_LEAD_US
+#define LT8722_SCHEDULER_LEAD_US 50         //time the timer fires before a setpoint is due
+#endif
+
+struct LT8722ScheduledSetpoint {
+    int64_t time;                           //time of the setpoint in microseconds (esp_timer_get_time())
+    uint32_t sequence;                      //order of setpoints with the same time
+    uint32_t code;                          //value of the SPIS_DAC register
+    uint8_t device;                         //index of the device
+    uint8_t frame[8];                       //encoded write frame
+};
+
+class LT8722Scheduler {
+public:
+    /**************************************************************************/
+    /*!
+        @brief Create the scheduler object
+    */
+    /**************************************************************************/
+    LT8722Scheduler();
+
+    /**************************************************************************/
+    /*!
+        @brief Create the timer that serves the setpoints of all devices
+        @param devices Array of LT8722 objects (begin() already called)
+        @param count Number of devices
+        @return Error (True) if the number of devices is not supported or
+                the timer could not be created
+    */
+    /**************************************************************************/
+    bool begin(LT8722* devices[], uint8_t count);
+
+    /**************************************************************************/
+    /*!
+        @brief Queue a setpoint for a device, the write frame is encoded
+               immediately. A setpoint in the past is sent as soon as
+               possible and counts as late.
+        @param index Index of the device in the array passed to begin()
+        @param time Time of the setpoint in microseconds (esp_timer_get_time())
+        @param code Register value from voltageCode()
+        @return Error (True) if the index is invalid or the queue is full
+    */
+    /**************************************************************************/
+    bool schedule(uint8_t index, int64_t time, LT8722::VoltageCode code);
+
+    /**************************************************************************/
+    /*!
+        @brief Remove all queued setpoints
+    */
+    /**************************************************************************/
+    void clear();
+
+    /**************************************************************************/
+    /*!
+        @brief Remove all queued setpoints and delete the timer
+    */
+    /**************************************************************************/
+    void end();
+
+    /**************************************************************************/
+    /*!
+        @brief Return the number of queued setpoints of all devices
+        @return Number of queued setpoints
+    */
+    /**************************************************************************/
+    uint8_t getPending();
+
+    /**************************************************************************/
+    /*!
+        @brief Return the current time of the timer used for scheduling
+        @return Time in microseconds
+    */
+    /**************************************************************************/
+    static int64_t getTime();
+
+    /**************************************************************************/
+    /*!
+        @brief Return the number of setpoints sent since the last reset of
+               the statistics
+        @return Number of sent setpoints
+    */
+    /**************************************************************************/
+    uint32_t getIssued();
+
+    /**************************************************************************/
+    /*!
+        @brief Return the number of setpoints with an SPI error since the
+               last reset of the statistics
+        @return Number of failed setpoints
+    */
+    /**************************************************************************/
+    uint32_t getFailed();
+
+    /**************************************************************************/
+    /*!
+        @brief Return the mean difference between the scheduled time and the
+               falling chip select of the frame
+        @return Mean issue-time error in microseconds
+    */
+    /**************************************************************************/
+    double getMeanError();
+
+    /**************************************************************************/
+    /*!
+        @brief Return the largest difference between the scheduled time and
+               the falling chip select of the frame
+        @return Maximum issue-time error in microseconds
+    */
+    /**************************************************************************/
+    uint32_t getMaxError();
+
+    /**************************************************************************/
+    /*!
+        @brief Reset the number of setpoints and the issue-time errors
+    */
+    /**************************************************************************/
+    void resetStatistics();
+
+private:
+    /**************************************************************************/
+    /*!
+        @brief Callback of the timer, forwards to service()
+        @param context Scheduler object
+    */
+    /**************************************************************************/
+    static void timerCallback(void *context);
+
+    /**************************************************************************/
+    /*!
+        @brief Send every setpoint that is due within the lead time and arm
+               the timer for the next one
+    */
+    /**************************************************************************/
+    void service();
+
+    /**************************************************************************/
+    /*!
+        @brief Arm the timer for the earliest setpoint, has to be called
+               without the lock held. The earliest setpoint is read again
+               after the timer was started, so a setpoint queued in the
+               meantime is not missed.
+    */
+    /**************************************************************************/
+    void arm();
+
+    /**************************************************************************/
+    /*!
+        @brief Compare two setpoints by time and sequence
+        @param a Index of the first setpoint in the heap
+        @param b Index of the second setpoint in the heap
+        @return True if the first setpoint is due before the second one
+    */
+    /**************************************************************************/
+    bool earlier(uint8_t a, uint8_t b);
+
+    /**************************************************************************/
+    /*!
+        @brief Remove the earliest setpoint from the heap, has to be called
+               with the lock held
+        @param entry Removed setpoint
+    */
+    /**************************************************************************/
+    void pop(LT8722ScheduledSetpoint &entry);
+
+    LT8722 *_devices[LT8722_SCHEDULER_MAX_DEVICES];
+    uint8_t _count;
+
+    LT8722ScheduledSetpoint _heap[LT8722_SCHEDULER_MAX_ENTRIES];
+    uint8_t _pending;
+    uint32_t _sequence;
+
+    esp_timer_handle_t _timer;
+    portMUX_TYPE _lock;
+
+    volatile uint32_t _issued;
+    volatile uint32_t _failed;
+    volatile uint32_t _maxError;
+    uint64_t _errorSum;
+};
+
+#endif
+#endif
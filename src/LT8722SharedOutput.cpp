@@ -0,0 +1,253 @@
+/*
+ * File Name: LT8722SharedOutput.cpp
+ * Description: Scheduler for several LT8722 whose analog outputs are tied
+ *              to one ADC pin. Exactly one device drives the line at a 
+ *              time, all other analog outputs are disabled (high impedance).
+ *              The devices take turns in fixed slots: while the active 
+ *              device settles, the AMUX of the next one is already selected
+ *              with its output disabled, so a handover only needs one frame
+ *              to disable the active device and one frame to enable the 
+ *              next one.
+ *
+ * Notes: This code was written as part of my master's thesis at the
+ *        Institute for Microsensors, -actuators and -systems (IMSAS)
+ *        at the University of Bremen.
+ */
+
+#include "LT8722SharedOutput.h"
+
+/**************************************************************************/
+/*!
+    @brief Create the shared output object
+*/
+/**************************************************************************/
+LT8722SharedOutput::LT8722SharedOutput() {
+    _count = 0;
+    _active = 0;
+    _analogInput = 0;
+    _settle = 0;
+    _slotStart = 0;
+    _start = 0;
+    _slots = 0;
+    _handoverTime = 0;
+
+    for (uint8_t i = 0; i < LT8722_SHARED_MAX_DEVICES; i++) {
+        _devices[i] = NULL;
+        _values[i] = ANALOG_OUTPUT::VOLTAGE;
+        _voltages[i] = 0.0;
+        _references1P25[i] = 1.25;
+        _references1P65[i] = 1.65;
+        _samples[i] = 0;
+    }
+}
+
+/**************************************************************************/
+/*!
+    @brief Take over the shared line: the analog outputs of all devices
+           are disabled, the references of every device are measured
+           and the first device is enabled
+    @param devices Array of LT8722 objects with the same analog input
+    @param count Number of devices
+    @param settle Settling time in microseconds after a handover
+    @return Error (True) if the SPI communication failed, the devices
+            do not share the same analog input or it is locked by
+            another owner
+*/
+/**************************************************************************/
+bool LT8722SharedOutput::begin(LT8722* devices[], uint8_t count, uint32_t settle) {
+    bool error = false;
+
+    if (count == 0 || count > LT8722_SHARED_MAX_DEVICES) {
+        return true;
+    }
+
+    for (uint8_t i = 0; i < count; i++) {
+        if (devices[i]->getAnalogInput() != devices[0]->getAnalogInput()) {
+            return true;
+        }
+        _devices[i] = devices[i];
+    }
+
+    //readAnalogOutput() of the devices fails until end()
+    if (LT8722::lockAnalogInput(devices[0]->getAnalogInput(), this)) {
+        return true;
+    }
+    _count = count;
+    _analogInput = devices[0]->getAnalogInput();
+    _settle = settle;
+
+    //no device may drive the line before the first one is enabled
+    for (uint8_t i = 0; i < _count; i++) {
+        error |= _devices[i]->selectAnalogOutput(ANALOG_OUTPUT::REFERENCE_1_25);
+    }
+
+    //the references are measured once, one device after another
+    for (uint8_t i = 0; i < _count; i++) {
+        _references1P25[i] = measure(i, ANALOG_OUTPUT::REFERENCE_1_25);
+        _references1P65[i] = measure(i, ANALOG_OUTPUT::REFERENCE_1_65);
+        _samples[i] = 0;
+    }
+
+    //first slot, the next device is prepared while the first one settles
+    _active = 0;
+    error |= _devices[0]->parkAnalogOutput(_values[0]);
+    _start = micros();
+    _slotStart = _start;
+    _slots = 0;
+    if (_count > 1) {
+        error |= _devices[1]->selectAnalogOutput(_values[1]);
+    }
+
+    return error;
+}
+
+/**************************************************************************/
+/*!
+    @brief Define the value of the analog output sampled for a device
+    @param index Index of the device in the array passed to begin()
+    @param value Predefined value of the analog output (VOLTAGE by default)
+*/
+/**************************************************************************/
+void LT8722SharedOutput::setValue(uint8_t index, ANALOG_OUTPUT value) {
+    if (index < LT8722_SHARED_MAX_DEVICES) {
+        _values[index] = value;
+    }
+}
+
+/**************************************************************************/
+/*!
+    @brief Sample the active device once it has settled and hand the 
+           line over to the next device, has to be called frequently 
+           (e.g. in the loop)
+    @return True if a new sample was taken
+*/
+/**************************************************************************/
+bool LT8722SharedOutput::service() {
+    if (_count == 0 || micros() - _slotStart < _settle) {
+        return false;
+    }
+
+    double voltage = analogReadMilliVolts(_analogInput);
+    _voltages[_active] = voltage / 1000;
+    _samples[_active]++;
+    _slots++;
+
+    if (_count == 1) {
+        _slotStart = micros();
+        return true;
+    }
+
+    //handover: the active device is disabled before the next one drives the line
+    uint8_t next = (_active + 1) % _count;
+    uint32_t handoverStart = micros();
+    _devices[_active]->selectAnalogOutput(_values[_active]);
+    _devices[next]->parkAnalogOutput(_values[next]);
+    _slotStart = micros();
+    _handoverTime = _slotStart - handoverStart;
+    _active = next;
+
+    //prepare the AMUX of the following device while the active one settles
+    uint8_t following = (_active + 1) % _count;
+    if (following != _active) {
+        _devices[following]->selectAnalogOutput(_values[following]);
+    }
+
+    return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief Disable the analog outputs of all devices and unlock the
+           analog input
+    @return Error (True) if an error accrued during the SPI communication
+*/
+/**************************************************************************/
+bool LT8722SharedOutput::end() {
+    bool error = false;
+
+    for (uint8_t i = 0; i < _count; i++) {
+        error |= _devices[i]->releaseAnalogOutput();
+    }
+    if (_count > 0) {
+        LT8722::unlockAnalogInput(_analogInput, this);
+    }
+    _count = 0;
+
+    return error;
+}
+
+/**************************************************************************/
+/*!
+    @brief Return the latest sample of a device converted like 
+           readAnalogOutput()
+    @param index Index of the device in the array passed to begin()
+    @return Converted value of the selected analog output
+*/
+/**************************************************************************/
+double LT8722SharedOutput::getValue(uint8_t index) {
+    if (index >= _count) {
+        return 0.0;
+    }
+
+    double reference = (_values[index] == ANALOG_OUTPUT::CURRENT) ? _references1P65[index] : _references1P25[index];
+    return LT8722::convertAnalogOutput(_values[index], _voltages[index], reference);
+}
+
+/**************************************************************************/
+/*!
+    @brief Return the number of samples per second of a device
+    @param index Index of the device in the array passed to begin()
+    @return Sample rate in Hz since begin()
+*/
+/**************************************************************************/
+double LT8722SharedOutput::getSampleRate(uint8_t index) {
+    uint32_t elapsed = micros() - _start;
+
+    if (index >= _count || elapsed == 0) {
+        return 0.0;
+    }
+
+    return _samples[index] * 1000000.0 / elapsed;
+}
+
+/**************************************************************************/
+/*!
+    @brief Return the average duration of one slot (settling, sampling,
+           handover and preparation of the next device)
+    @return Slot time in microseconds
+*/
+/**************************************************************************/
+uint32_t LT8722SharedOutput::getSlotTime() {
+    return (_slots > 0) ? (_slotStart - _start) / _slots : 0;
+}
+
+/**************************************************************************/
+/*!
+    @brief Return the duration of the last handover (disable and enable
+           frame)
+    @return Handover time in microseconds
+*/
+/**************************************************************************/
+uint32_t LT8722SharedOutput::getHandoverTime() {
+    return _handoverTime;
+}
+
+/**************************************************************************/
+/*!
+    @brief Measure a value of the analog output of one device that is 
+           already selected with its output disabled
+    @param index Index of the device
+    @param value Predefined value to be measured
+    @return Voltage of the analog output pin in volts
+*/
+/**************************************************************************/
+double LT8722SharedOutput::measure(uint8_t index, ANALOG_OUTPUT value) {
+    _devices[index]->parkAnalogOutput(value);
+    delayMicroseconds(_settle);
+
+    double voltage = analogReadMilliVolts(_analogInput);
+
+    _devices[index]->selectAnalogOutput(value);
+
+    return voltage / 1000;
+}
@@ -0,0 +1,145 @@
+/*
+ * File Name: LT8722SharedOutput.h
+ * Description: Scheduler for several LT8722 whose analog outputs are tied
+ *              to one ADC pin. Exactly one device drives the line at a 
+ *              time, all other analog outputs are disabled (high impedance).
+ *              The devices take turns in fixed slots: while the active 
+ *              device settles, the AMUX of the next one is already selected
+ *              with its output disabled, so a handover only needs one frame
+ *              to disable the active device and one frame to enable the 
+ *              next one.
+ *
+ * Notes: This code was written as part of my master's thesis at the
+ *        Institute for Microsensors, -actuators and -systems (IMSAS)
+ *        at the University of Bremen.
+ */
+
+#ifndef LT8722SHAREDOUTPUT_H
+#define LT8722SHAREDOUTPUT_H
+
+#include <Arduino.h>
+#include "LT8722.h"
+
+#ifndef LT8722_SHARED_MAX_DEVICES
+#define LT8722_SHARED_MAX_DEVICES 16
+#endif
+
+class LT8722SharedOutput {
+public:
+    /**************************************************************************/
+    /*!
+        @brief Create the shared output object
+    */
+    /**************************************************************************/
+    LT8722SharedOutput();
+
+    /**************************************************************************/
+    /*!
+        @brief Take over the shared line: the analog outputs of all devices
+               are disabled, the references of every device are measured
+               and the first device is enabled
+        @param devices Array of LT8722 objects with the same analog input
+        @param count Number of devices
+        @param settle Settling time in microseconds after a handover
+        @return Error (True) if the SPI communication failed, the devices
+                do not share the same analog input or it is locked by
+                another owner
+    */
+    /**************************************************************************/
+    bool begin(LT8722* devices[], uint8_t count, uint32_t settle = 200);
+
+    /**************************************************************************/
+    /*!
+        @brief Define the value of the analog output sampled for a device
+        @param index Index of the device in the array passed to begin()
+        @param value Predefined value of the analog output (VOLTAGE by default)
+    */
+    /**************************************************************************/
+    void setValue(uint8_t index, ANALOG_OUTPUT value);
+
+    /**************************************************************************/
+    /*!
+        @brief Sample the active device once it has settled and hand the 
+               line over to the next device, has to be called frequently 
+               (e.g. in the loop)
+        @return True if a new sample was taken
+    */
+    /**************************************************************************/
+    bool service();
+
+    /**************************************************************************/
+    /*!
+        @brief Disable the analog outputs of all devices and unlock the
+               analog input
+        @return Error (True) if an error accrued during the SPI communication
+    */
+    /**************************************************************************/
+    bool end();
+
+    /**************************************************************************/
+    /*!
+        @brief Return the latest sample of a device converted like 
+               readAnalogOutput()
+        @param index Index of the device in the array passed to begin()
+        @return Converted value of the selected analog output
+    */
+    /**************************************************************************/
+    double getValue(uint8_t index);
+
+    /**************************************************************************/
+    /*!
+        @brief Return the number of samples per second of a device
+        @param index Index of the device in the array passed to begin()
+        @return Sample rate in Hz since begin()
+    */
+    /**************************************************************************/
+    double getSampleRate(uint8_t index);
+
+    /**************************************************************************/
+    /*!
+        @brief Return the average duration of one slot (settling, sampling,
+               handover and preparation of the next device)
+        @return Slot time in microseconds
+    */
+    /**************************************************************************/
+    uint32_t getSlotTime();
+
+    /**************************************************************************/
+    /*!
+        @brief Return the duration of the last handover (disable and enable
+               frame)
+        @return Handover time in microseconds
+    */
+    /**************************************************************************/
+    uint32_t getHandoverTime();
+
+private:
+    /**************************************************************************/
+    /*!
+        @brief Measure a value of the analog output of one device that is 
+               already selected with its output disabled
+        @param index Index of the device
+        @param value Predefined value to be measured
+        @return Voltage of the analog output pin in volts
+    */
+    /**************************************************************************/
+    double measure(uint8_t index, ANALOG_OUTPUT value);
+
+    LT8722 *_devices[LT8722_SHARED_MAX_DEVICES];
+    ANALOG_OUTPUT _values[LT8722_SHARED_MAX_DEVICES];
+    double _voltages[LT8722_SHARED_MAX_DEVICES];
+    double _references1P25[LT8722_SHARED_MAX_DEVICES];
+    double _references1P65[LT8722_SHARED_MAX_DEVICES];
+    uint32_t _samples[LT8722_SHARED_MAX_DEVICES];
+    uint8_t _count;
+    uint8_t _active;
+    uint8_t _analogInput;
+
+    uint32_t _settle;
+    uint32_t _slotStart;
+    uint32_t _start;
+    uint32_t _slots;
+    uint32_t _handoverTime;
+};
+
+#endif
@@ -0,0 +1,257 @@
+/*
+ * File Name: LT8722Stream.cpp
+ * Description: Autonomous playback of LT8722 frames with the LCD (i80)
+ *              peripheral of the ESP32-S3. A bit stream from 
+ *              LT8722Bitstream (SCK, MOSI and chip selects as parallel 
+ *              samples) is clocked out by DMA from two buffers in turn, so
+ *              the CPU only refills the buffer that has been sent. The 
+ *              LT8722 answers are not read back in this mode.
+ *
+ * Notes: This code was written as part of my master's thesis at the
+ *        Institute for Microsensors, -actuators and -systems (IMSAS)
+ *        at the University of Bremen.
+ */
+
+#include "LT8722Stream.h"
+
+#if __has_include(<esp_lcd_panel_io.h>) && SOC_LCD_I80_SUPPORTED
+#include <esp_heap_caps.h>
+
+/**************************************************************************/
+/*!
+    @brief Create the stream object
+*/
+/**************************************************************************/
+LT8722Stream::LT8722Stream() {
+    _bus = NULL;
+    _io = NULL;
+    _buffers[0] = NULL;
+    _buffers[1] = NULL;
+    _bufferSize = 0;
+    _next = 0;
+    _fill = NULL;
+    _context = NULL;
+    _running = false;
+    _sent = 0;
+    _underruns = 0;
+    _refilled = 0;
+}
+
+/**************************************************************************/
+/*!
+    @brief Route SCK, MOSI and the chip selects to the LCD peripheral and
+           allocate the two DMA buffers. The bus always drives eight
+           lines, so unused chip select lanes need free GPIOs. The SPI
+           peripheral loses these pins until LT8722::begin() is called
+           again.
+    @param pins SCK, MOSI and the chip selects of lane 0 to 5
+    @param wr Free GPIO for the write clock of the LCD peripheral
+    @param dc Free GPIO for the data/command line of the LCD peripheral
+    @param bitRate SPI bit rate in Hz (two samples per bit)
+    @param bufferSize Size of one DMA buffer in samples
+    @return Error (True) if the peripheral or the buffers could not be 
+            set up
+*/
+/**************************************************************************/
+bool LT8722Stream::begin(const uint8_t pins[8], uint8_t wr, uint8_t dc, uint32_t bitRate, uint32_t bufferSize) {
+    if (_bus != NULL) {
+        return true;
+    }
+
+    esp_lcd_i80_bus_config_t busConfig = {};
+    busConfig.clk_src = LCD_CLK_SRC_DEFAULT;
+    busConfig.dc_gpio_num = dc;
+    busConfig.wr_gpio_num = wr;
+    for (uint8_t i = 0; i < 8; i++) {
+        busConfig.data_gpio_nums[i] = pins[i];          //bit i of a sample drives pins[i]
+    }
+    busConfig.bus_width = 8;
+    busConfig.max_transfer_bytes = bufferSize;
+
+    if (esp_lcd_new_i80_bus(&busConfig, &_bus) != ESP_OK) {
+        _bus = NULL;
+        return true;
+    }
+
+    esp_lcd_panel_io_i80_config_t ioConfig = {};
+    ioConfig.cs_gpio_num = -1;
+    ioConfig.pclk_hz = 2 * bitRate;                     //SCK low and high sample per bit
+    ioConfig.trans_queue_depth = 2;
+    ioConfig.on_color_trans_done = transferDone;
+    ioConfig.user_ctx = this;
+    ioConfig.lcd_cmd_bits = 8;
+    ioConfig.lcd_param_bits = 8;
+
+    bool error = esp_lcd_new_panel_io_i80(_bus, &ioConfig, &_io) != ESP_OK;
+
+    for (uint8_t i = 0; i < 2 && !error; i++) {
+        _buffers[i] = (uint8_t *)heap_caps_malloc(bufferSize, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+        error |= (_buffers[i] == NULL);
+    }
+
+    if (error) {
+        end();
+        return true;
+    }
+
+    _bufferSize = bufferSize;
+    return false;
+}
+
+/**************************************************************************/
+/*!
+    @brief Fill both buffers and start the playback. The fill function
+           writes the next samples into a buffer and returns their 
+           number, every buffer has to end in the idle state.
+    @param fill Function that provides the next samples
+    @param context Pointer passed to the fill function
+    @return Error (True) if the transfers could not be queued
+*/
+/**************************************************************************/
+bool LT8722Stream::start(LT8722StreamFill fill, void *context) {
+    if (_io == NULL || fill == NULL || _running) {
+        return true;
+    }
+
+    _fill = fill;
+    _context = context;
+    _sent = 0;
+    _underruns = 0;
+    _refilled = 0;
+    _next = 0;
+    _running = true;
+
+    bool error = refill(0);
+    error |= refill(1);
+
+    return error;
+}
+
+/**************************************************************************/
+/*!
+    @brief Refill and queue the buffers that have been sent, has to be 
+           called frequently (e.g. in the loop)
+    @return Error (True) if the fill function provided no samples or a
+            transfer could not be queued
+*/
+/**************************************************************************/
+bool LT8722Stream::service() {
+    bool error = false;
+
+    //buffers are sent in order, every sent buffer can be refilled
+    while (_running && !error && _refilled - _sent < 2) {
+        error = refill(_next);
+    }
+
+    return error;
+}
+
+/**************************************************************************/
+/*!
+    @brief Stop refilling, the queued buffers are still sent
+*/
+/**************************************************************************/
+void LT8722Stream::stop() {
+    _running = false;
+}
+
+/**************************************************************************/
+/*!
+    @brief Release the LCD peripheral and the buffers
+*/
+/**************************************************************************/
+void LT8722Stream::end() {
+    _running = false;
+
+    //wait until the queued buffers have been sent
+    uint32_t start = millis();
+    while (_refilled != _sent && millis() - start < 100) {
+        delay(1);
+    }
+
+    if (_io != NULL) {
+        esp_lcd_panel_io_del(_io);
+        _io = NULL;
+    }
+    if (_bus != NULL) {
+        esp_lcd_del_i80_bus(_bus);
+        _bus = NULL;
+    }
+    for (uint8_t i = 0; i < 2; i++) {
+        if (_buffers[i] != NULL) {
+            heap_caps_free(_buffers[i]);
+            _buffers[i] = NULL;
+        }
+    }
+}
+
+/**************************************************************************/
+/*!
+    @brief Return the number of buffers sent since start()
+    @return Number of sent buffers
+*/
+/**************************************************************************/
+uint32_t LT8722Stream::getBuffers() {
+    return _sent;
+}
+
+/**************************************************************************/
+/*!
+    @brief Return how often the DMA ran out of buffers because a refill
+           came too late (the lines stay idle until the next buffer)
+    @return Number of underruns since start()
+*/
+/**************************************************************************/
+uint32_t LT8722Stream::getUnderruns() {
+    return _underruns;
+}
+
+/**************************************************************************/
+/*!
+    @brief Called by the LCD driver in the interrupt after a buffer has 
+           been sent
+    @param io Handle of the panel IO
+    @param event Event data of the driver
+    @param context Pointer to the stream object
+    @return False, no task has to be woken
+*/
+/**************************************************************************/
+bool IRAM_ATTR LT8722Stream::transferDone(esp_lcd_panel_io_handle_t io, esp_lcd_panel_io_event_data_t *event, void *context) {
+    LT8722Stream *stream = (LT8722Stream *)context;
+
+    stream->_sent++;
+    if (stream->_sent == stream->_refilled && stream->_running) {
+        stream->_underruns++;
+    }
+
+    return false;
+}
+
+/**************************************************************************/
+/*!
+    @brief Fill a buffer and queue it for the DMA
+    @param index Index of the buffer
+    @return Error (True) if no samples were provided or the transfer
+            could not be queued
+*/
+/**************************************************************************/
+bool LT8722Stream::refill(uint8_t index) {
+    uint32_t length = _fill(_buffers[index], _bufferSize, _context);
+
+    if (length == 0) {
+        return true;
+    }
+
+    //without command phase, only the samples are clocked out
+    _refilled++;
+    if (esp_lcd_panel_io_tx_color(_io, -1, _buffers[index], length) != ESP_OK) {
+        _refilled--;
+        return true;
+    }
+
+    _next = index ^ 0x01;
+
+    return false;
+}
+
+#endif
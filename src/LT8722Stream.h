@@ -0,0 +1,147 @@
+/*
+ * File Name: LT8722Stream.h
+ * Description: Autonomous playback of LT8722 frames with the LCD (i80)
+ *              peripheral of the ESP32-S3. A bit stream from 
+ *              LT8722Bitstream (SCK, MOSI and chip selects as parallel 
+ *              samples) is clocked out by DMA from two buffers in turn, so
+ *              the CPU only refills the buffer that has been sent. The 
+ *              LT8722 answers are not read back in this mode.
+ *
+ * Notes: This code was written as part of my master's thesis at the
+ *        Institute for Microsensors, -actuators and -systems (IMSAS)
+ *        at the University of Bremen.
+ */
+
+#ifndef LT8722STREAM_H
+#define LT8722STREAM_H
+
+#include <Arduino.h>
+#include <soc/soc_caps.h>
+
+#if __has_include(<esp_lcd_panel_io.h>) && SOC_LCD_I80_SUPPORTED
+#include <esp_lcd_panel_io.h>
+#include "LT8722Bitstream.h"
+
+typedef uint32_t (*LT8722StreamFill)(uint8_t *buffer, uint32_t capacity, void *context);
+
+class LT8722Stream {
+public:
+    /**************************************************************************/
+    /*!
+        @brief Create the stream object
+    */
+    /**************************************************************************/
+    LT8722Stream();
+
+    /**************************************************************************/
+    /*!
+        @brief Route SCK, MOSI and the chip selects to the LCD peripheral and
+               allocate the two DMA buffers. The bus always drives eight
+               lines, so unused chip select lanes need free GPIOs. The SPI
+               peripheral loses these pins until LT8722::begin() is called
+               again.
+        @param pins SCK, MOSI and the chip selects of lane 0 to 5
+        @param wr Free GPIO for the write clock of the LCD peripheral
+        @param dc Free GPIO for the data/command line of the LCD peripheral
+        @param bitRate SPI bit rate in Hz (two samples per bit)
+        @param bufferSize Size of one DMA buffer in samples
+        @return Error (True) if the peripheral or the buffers could not be 
+                set up
+    */
+    /**************************************************************************/
+    bool begin(const uint8_t pins[8], uint8_t wr, uint8_t dc, uint32_t bitRate = 4000000, uint32_t bufferSize = 4096);
+
+    /**************************************************************************/
+    /*!
+        @brief Fill both buffers and start the playback. The fill function
+               writes the next samples into a buffer and returns their 
+               number, every buffer has to end in the idle state.
+        @param fill Function that provides the next samples
+        @param context Pointer passed to the fill function
+        @return Error (True) if the transfers could not be queued
+    */
+    /**************************************************************************/
+    bool start(LT8722StreamFill fill, void *context);
+
+    /**************************************************************************/
+    /*!
+        @brief Refill and queue the buffers that have been sent, has to be 
+               called frequently (e.g. in the loop)
+        @return Error (True) if the fill function provided no samples or a
+                transfer could not be queued
+    */
+    /**************************************************************************/
+    bool service();
+
+    /**************************************************************************/
+    /*!
+        @brief Stop refilling, the queued buffers are still sent
+    */
+    /**************************************************************************/
+    void stop();
+
+    /**************************************************************************/
+    /*!
+        @brief Release the LCD peripheral and the buffers
+    */
+    /**************************************************************************/
+    void end();
+
+    /**************************************************************************/
+    /*!
+        @brief Return the number of buffers sent since start()
+        @return Number of sent buffers
+    */
+    /**************************************************************************/
+    uint32_t getBuffers();
+
+    /**************************************************************************/
+    /*!
+        @brief Return how often the DMA ran out of buffers because a refill
+               came too late (the lines stay idle until the next buffer)
+        @return Number of underruns since start()
+    */
+    /**************************************************************************/
+    uint32_t getUnderruns();
+
+private:
+    /**************************************************************************/
+    /*!
+        @brief Called by the LCD driver in the interrupt after a buffer has 
+               been sent
+        @param io Handle of the panel IO
+        @param event Event data of the driver
+        @param context Pointer to the stream object
+        @return False, no task has to be woken
+    */
+    /**************************************************************************/
+    static bool transferDone(esp_lcd_panel_io_handle_t io, esp_lcd_panel_io_event_data_t *event, void *context);
+
+    /**************************************************************************/
+    /*!
+        @brief Fill a buffer and queue it for the DMA
+        @param index Index of the buffer
+        @return Error (True) if no samples were provided or the transfer
+                could not be queued
+    */
+    /**************************************************************************/
+    bool refill(uint8_t index);
+
+    esp_lcd_i80_bus_handle_t _bus;
+    esp_lcd_panel_io_handle_t _io;
+    uint8_t *_buffers[2];
+    uint32_t _bufferSize;
+    uint8_t _next;
+
+    LT8722StreamFill _fill;
+    void *_context;
+    bool _running;
+
+    volatile uint32_t _sent;
+    volatile uint32_t _refilled;
+    volatile uint32_t _underruns;
+};
+
+#endif
+
+#endif
@@ -0,0 +1,366 @@
+/*
+ * File Name: LT8722Telemetry.cpp
+ * Description: Telemetry of many LT8722 whose analog outputs are wired to 
+ *              separate ADC pins. The pattern table of the continuous ADC 
+ *              scans the pins of all devices in one DMA stream, while the
+ *              AMUX of every device is switched together through voltage,
+ *              current, temperature and the two references. The samples
+ *              are demultiplexed by their ADC channel and averaged into
+ *              one snapshot per device.
+ *
+ * Notes: This code was written as part of my master's thesis at the
+ *        Institute for Microsensors, -actuators and -systems (IMSAS)
+ *        at the University of Bremen.
+ */
+
+#include "LT8722Telemetry.h"
+
+#if __has_include(<esp_adc/adc_continuous.h>)
+
+#if CONFIG_IDF_TARGET_ESP32 || CONFIG_IDF_TARGET_ESP32S2
+#define ADC_OUTPUT_FORMAT ADC_DIGI_OUTPUT_FORMAT_TYPE1
+#define ADC_GET_DATA(p) ((p)->type1.data)
+#define ADC_GET_CHANNEL(p) ((p)->type1.channel)
+#else
+#define ADC_OUTPUT_FORMAT ADC_DIGI_OUTPUT_FORMAT_TYPE2
+#define ADC_GET_DATA(p) ((p)->type2.data)
+#define ADC_GET_CHANNEL(p) ((p)->type2.channel)
+#endif
+
+//AMUX values of one telemetry cycle, each measurement is followed by its reference
+static const ANALOG_OUTPUT PHASES[LT8722_TELEMETRY_PHASES] = {
+    ANALOG_OUTPUT::VOLTAGE,
+    ANALOG_OUTPUT::REFERENCE_1_25,
+    ANALOG_OUTPUT::CURRENT,
+    ANALOG_OUTPUT::REFERENCE_1_65,
+    ANALOG_OUTPUT::TEMPERATURE
+};
+
+/**************************************************************************/
+/*!
+    @brief Create the telemetry object
+*/
+/**************************************************************************/
+LT8722Telemetry::LT8722Telemetry() {
+    _count = 0;
+    _settleSamples = 0;
+    _dwellSamples = 1;
+    _phase = 0;
+    _pending = 0;
+    _sequence = 0;
+    _cycleStart = 0;
+    _cycleTime = 0;
+    _adc = NULL;
+    _cali = NULL;
+
+    for (uint8_t i = 0; i < 16; i++) {
+        _channelToDevice[i] = -1;
+    }
+
+    for (uint8_t i = 0; i < LT8722_TELEMETRY_MAX_DEVICES; i++) {
+        _devices[i] = NULL;
+        _samples[i] = 0;
+        _sum[i] = 0;
+        _snapshots[i] = {0.0, 0.0, 0.0, 0, 0};
+    }
+}
+
+/**************************************************************************/
+/*!
+    @brief Program the pattern table with the analog inputs of all 
+           devices and start the ADC in continuous mode. All pins have
+           to belong to the same ADC unit.
+    @param devices Array of LT8722 objects (begin() already called)
+    @param count Number of devices
+    @param sampleRate Aggregate sample rate of all pins in Hz
+    @param settle Time in microseconds discarded after an AMUX change
+    @param dwell Time in microseconds averaged for every AMUX value
+    @return Error (True) if the SPI communication or the ADC failed or
+            another owner holds an analog input
+*/
+/**************************************************************************/
+bool LT8722Telemetry::begin(LT8722* devices[], uint8_t count, uint32_t sampleRate, uint32_t settle, uint32_t dwell) {
+    adc_digi_pattern_config_t patterns[LT8722_TELEMETRY_MAX_DEVICES] = {};
+    adc_unit_t firstUnit = ADC_UNIT_1;
+
+    if (count == 0 || count > LT8722_TELEMETRY_MAX_DEVICES || _adc != NULL) {
+        return true;
+    }
+
+    //one pattern table entry per device, the channel identifies the device in the DMA stream
+    for (uint8_t i = 0; i < count; i++) {
+        adc_unit_t unit;
+        adc_channel_t channel;
+
+        if (adc_continuous_io_to_channel(devices[i]->getAnalogInput(), &unit, &channel) != ESP_OK) {
+            stop();                                         //forget the devices mapped so far
+            return true;
+        }
+        if (i == 0) {
+            firstUnit = unit;
+        }
+        if (unit != firstUnit || _channelToDevice[channel] != -1) {
+            stop();
+            return true;                                    //other ADC unit or pin used twice
+        }
+        if (LT8722::lockAnalogInput(devices[i]->getAnalogInput(), this)) {
+            stop();
+            return true;                                    //line driven by another owner
+        }
+
+        _devices[i] = devices[i];
+        _channelToDevice[channel] = i;
+
+        patterns[i].atten = ADC_ATTEN_DB_12;
+        patterns[i].channel = channel;
+        patterns[i].unit = unit;
+        patterns[i].bit_width = SOC_ADC_DIGI_MAX_BITWIDTH;
+    }
+    _count = count;
+
+    //settling and averaging in samples of a single pin
+    uint64_t pinRate = sampleRate / count;
+    _settleSamples = pinRate * settle / 1000000;
+    _dwellSamples = pinRate * dwell / 1000000;
+    if (_dwellSamples == 0) {
+        _dwellSamples = 1;
+    }
+
+    adc_continuous_handle_cfg_t handleConfig = {};
+    handleConfig.max_store_buf_size = 4096;
+    handleConfig.conv_frame_size = 256;
+
+    adc_continuous_config_t config = {};
+    config.pattern_num = count;
+    config.adc_pattern = patterns;
+    config.sample_freq_hz = sampleRate;
+    config.conv_mode = (firstUnit == ADC_UNIT_1) ? ADC_CONV_SINGLE_UNIT_1 : ADC_CONV_SINGLE_UNIT_2;
+    config.format = ADC_OUTPUT_FORMAT;
+
+    bool error = false;
+
+#if ADC_CALI_SCHEME_CURVE_FITTING_SUPPORTED
+    adc_cali_curve_fitting_config_t caliConfig = {};
+    caliConfig.unit_id = firstUnit;
+    caliConfig.chan = static_cast<adc_channel_t>(patterns[0].channel);
+    caliConfig.atten = ADC_ATTEN_DB_12;
+    caliConfig.bitwidth = ADC_BITWIDTH_12;
+    error |= adc_cali_create_scheme_curve_fitting(&caliConfig, &_cali) != ESP_OK;
+#else
+    adc_cali_line_fitting_config_t caliConfig = {};
+    caliConfig.unit_id = firstUnit;
+    caliConfig.atten = ADC_ATTEN_DB_12;
+    caliConfig.bitwidth = ADC_BITWIDTH_12;
+    error |= adc_cali_create_scheme_line_fitting(&caliConfig, &_cali) != ESP_OK;
+#endif
+
+    error |= adc_continuous_new_handle(&handleConfig, &_adc) != ESP_OK;
+    if (!error) {
+        error |= adc_continuous_config(_adc, &config) != ESP_OK;
+        error |= adc_continuous_start(_adc) != ESP_OK;
+    }
+
+    _phase = 0;
+    _cycleStart = micros();
+    error |= switchAnalogOutputs();
+
+    if (error) {
+        stop();
+        return true;
+    }
+
+    return false;
+}
+
+/**************************************************************************/
+/*!
+    @brief Demultiplex the samples of the ADC and switch the AMUX of all
+           devices when every pin has enough samples, has to be called
+           frequently (e.g. in the loop)
+    @return True if new snapshots of all devices are available
+*/
+/**************************************************************************/
+bool LT8722Telemetry::service() {
+    uint8_t result[256];
+    uint32_t length = 0;
+    bool complete = false;
+
+    while (_adc != NULL && adc_continuous_read(_adc, result, sizeof(result), &length, 0) == ESP_OK) {
+        for (uint32_t i = 0; i + SOC_ADC_DIGI_RESULT_BYTES <= length; i += SOC_ADC_DIGI_RESULT_BYTES) {
+            adc_digi_output_data_t *output = (adc_digi_output_data_t *)&result[i];
+            int8_t index = _channelToDevice[ADC_GET_CHANNEL(output) & 0x0F];
+            if (index < 0) {
+                continue;
+            }
+
+            int millivolts = 0;
+            adc_cali_raw_to_voltage(_cali, ADC_GET_DATA(output), &millivolts);
+
+            //the rest of the block was converted before the AMUX change
+            if (push(index, millivolts)) {
+                complete |= advance();
+                break;
+            }
+        }
+    }
+
+    return complete;
+}
+
+/**************************************************************************/
+/*!
+    @brief Add one demultiplexed sample of a device. Called by service(),
+           but can also be used with samples from other sources
+    @param index Index of the device in the array passed to begin()
+    @param millivolts Sample in millivolts
+    @return True if every device has enough samples for the current
+            AMUX value
+*/
+/**************************************************************************/
+bool LT8722Telemetry::push(uint8_t index, uint16_t millivolts) {
+    if (index >= _count) {
+        return false;
+    }
+
+    uint32_t sample = _samples[index];
+    if (sample >= _settleSamples + _dwellSamples) {
+        return _pending == 0;
+    }
+
+    if (sample >= _settleSamples) {
+        _sum[index] += millivolts;
+    }
+    _samples[index] = sample + 1;
+
+    if (sample + 1 == _settleSamples + _dwellSamples) {
+        _pending--;
+    }
+
+    return _pending == 0;
+}
+
+/**************************************************************************/
+/*!
+    @brief Finish the current AMUX value and switch all devices to the
+           next one. Called by service() when push() returns True.
+    @return True if the telemetry cycle is complete and new snapshots
+            are available
+*/
+/**************************************************************************/
+bool LT8722Telemetry::advance() {
+    for (uint8_t i = 0; i < _count; i++) {
+        _average[i][_phase] = (_samples[i] > _settleSamples) ? (double)_sum[i] / (_samples[i] - _settleSamples) / 1000 : 0.0;
+    }
+
+    _phase++;
+    bool complete = (_phase == LT8722_TELEMETRY_PHASES);
+
+    if (complete) {
+        uint32_t now = micros();
+        _cycleTime = now - _cycleStart;
+        _cycleStart = now;
+        _sequence++;
+
+        for (uint8_t i = 0; i < _count; i++) {
+            _snapshots[i].voltage = LT8722::convertAnalogOutput(ANALOG_OUTPUT::VOLTAGE, _average[i][0], _average[i][1]);
+            _snapshots[i].current = LT8722::convertAnalogOutput(ANALOG_OUTPUT::CURRENT, _average[i][2], _average[i][3]);
+            _snapshots[i].temperature = LT8722::convertAnalogOutput(ANALOG_OUTPUT::TEMPERATURE, _average[i][4], 0.0);
+            _snapshots[i].timestamp = now;
+            _snapshots[i].sequence = _sequence;
+        }
+        _phase = 0;
+    }
+
+    switchAnalogOutputs();
+
+    return complete;
+}
+
+/**************************************************************************/
+/*!
+    @brief Stop the ADC and disable the analog outputs of all devices
+*/
+/**************************************************************************/
+void LT8722Telemetry::stop() {
+    if (_adc != NULL) {
+        adc_continuous_stop(_adc);
+        adc_continuous_deinit(_adc);
+        _adc = NULL;
+    }
+
+    if (_cali != NULL) {
+#if ADC_CALI_SCHEME_CURVE_FITTING_SUPPORTED
+        adc_cali_delete_scheme_curve_fitting(_cali);
+#else
+        adc_cali_delete_scheme_line_fitting(_cali);
+#endif
+        _cali = NULL;
+    }
+
+    for (uint8_t i = 0; i < _count; i++) {
+        _devices[i]->releaseAnalogOutput();
+    }
+
+    for (uint8_t i = 0; i < LT8722_TELEMETRY_MAX_DEVICES; i++) {
+        if (_devices[i] != NULL) {
+            LT8722::unlockAnalogInput(_devices[i]->getAnalogInput(), this);
+        }
+        _devices[i] = NULL;
+    }
+    for (uint8_t i = 0; i < 16; i++) {
+        _channelToDevice[i] = -1;
+    }
+    _count = 0;
+}
+
+/**************************************************************************/
+/*!
+    @brief Return the latest snapshot of a device
+    @param index Index of the device in the array passed to begin()
+    @return Snapshot with voltage, current and temperature
+*/
+/**************************************************************************/
+LT8722Snapshot LT8722Telemetry::getSnapshot(uint8_t index) {
+    if (index >= LT8722_TELEMETRY_MAX_DEVICES) {
+        return _snapshots[0];
+    }
+    return _snapshots[index];
+}
+
+/**************************************************************************/
+/*!
+    @brief Return the measured number of snapshots per second of one
+           device, all devices are updated at this rate at the same time
+    @return Snapshot rate in Hz
+*/
+/**************************************************************************/
+double LT8722Telemetry::getSnapshotRate() {
+    return (_cycleTime > 0) ? 1000000.0 / _cycleTime : 0.0;
+}
+
+/**************************************************************************/
+/*!
+    @brief Switch the AMUX of all devices to the value of the current
+           phase and discard the samples converted before
+    @return Error (True) if an error accrued during the SPI communication
+*/
+/**************************************************************************/
+bool LT8722Telemetry::switchAnalogOutputs() {
+    bool error = false;
+
+    //one frame per device, all analog outputs settle at the same time
+    for (uint8_t i = 0; i < _count; i++) {
+        error |= _devices[i]->parkAnalogOutput(PHASES[_phase]);
+        _samples[i] = 0;
+        _sum[i] = 0;
+    }
+    _pending = _count;
+
+    if (_adc != NULL) {
+        adc_continuous_flush_pool(_adc);
+    }
+
+    return error;
+}
+
+#endif
@@ -0,0 +1,157 @@
+/*
+ * File Name: LT8722Telemetry.h
+ * Description: Telemetry of many LT8722 whose analog outputs are wired to 
+ *              separate ADC pins. The pattern table of the continuous ADC 
+ *              scans the pins of all devices in one DMA stream, while the
+ *              AMUX of every device is switched together through voltage,
+ *              current, temperature and the two references. The samples
+ *              are demultiplexed by their ADC channel and averaged into
+ *              one snapshot per device.
+ *
+ * Notes: This code was written as part of my master's thesis at the
+ *        Institute for Microsensors, -actuators and -systems (IMSAS)
+ *        at the University of Bremen.
+ */
+
+#ifndef LT8722TELEMETRY_H
+#define LT8722TELEMETRY_H
+
+#include <Arduino.h>
+
+#if __has_include(<esp_adc/adc_continuous.h>)
+#include <esp_adc/adc_continuous.h>
+#include <esp_adc/adc_cali.h>
+#include <esp_adc/adc_cali_scheme.h>
+#include "LT8722.h"
+
+#ifndef LT8722_TELEMETRY_MAX_DEVICES
+#define LT8722_TELEMETRY_MAX_DEVICES 10     //number of channels of one ADC unit
+#endif
+
+#define LT8722_TELEMETRY_PHASES 5           //number of AMUX values in one telemetry cycle
+
+struct LT8722Snapshot {
+    double voltage;                         //output voltage in volts
+    double current;                         //output current in amperes
+    double temperature;                     //die temperature in degrees Celsius
+    uint32_t timestamp;                     //end of the telemetry cycle in microseconds
+    uint32_t sequence;                      //number of the telemetry cycle
+};
+
+class LT8722Telemetry {
+public:
+    /**************************************************************************/
+    /*!
+        @brief Create the telemetry object
+    */
+    /**************************************************************************/
+    LT8722Telemetry();
+
+    /**************************************************************************/
+    /*!
+        @brief Program the pattern table with the analog inputs of all 
+               devices and start the ADC in continuous mode. All pins have
+               to belong to the same ADC unit.
+        @param devices Array of LT8722 objects (begin() already called)
+        @param count Number of devices
+        @param sampleRate Aggregate sample rate of all pins in Hz
+        @param settle Time in microseconds discarded after an AMUX change
+        @param dwell Time in microseconds averaged for every AMUX value
+        @return Error (True) if the SPI communication or the ADC failed or
+                another owner holds an analog input
+    */
+    /**************************************************************************/
+    bool begin(LT8722* devices[], uint8_t count, uint32_t sampleRate = SOC_ADC_SAMPLE_FREQ_THRES_HIGH,
+               uint32_t settle = 500, uint32_t dwell = 1000);
+
+    /**************************************************************************/
+    /*!
+        @brief Demultiplex the samples of the ADC and switch the AMUX of all
+               devices when every pin has enough samples, has to be called
+               frequently (e.g. in the loop)
+        @return True if new snapshots of all devices are available
+    */
+    /**************************************************************************/
+    bool service();
+
+    /**************************************************************************/
+    /*!
+        @brief Add one demultiplexed sample of a device. Called by service(),
+               but can also be used with samples from other sources
+        @param index Index of the device in the array passed to begin()
+        @param millivolts Sample in millivolts
+        @return True if every device has enough samples for the current
+                AMUX value
+    */
+    /**************************************************************************/
+    bool push(uint8_t index, uint16_t millivolts);
+
+    /**************************************************************************/
+    /*!
+        @brief Finish the current AMUX value and switch all devices to the
+               next one. Called by service() when push() returns True.
+        @return True if the telemetry cycle is complete and new snapshots
+                are available
+    */
+    /**************************************************************************/
+    bool advance();
+
+    /**************************************************************************/
+    /*!
+        @brief Stop the ADC and disable the analog outputs of all devices
+    */
+    /**************************************************************************/
+    void stop();
+
+    /**************************************************************************/
+    /*!
+        @brief Return the latest snapshot of a device
+        @param index Index of the device in the array passed to begin()
+        @return Snapshot with voltage, current and temperature
+    */
+    /**************************************************************************/
+    LT8722Snapshot getSnapshot(uint8_t index);
+
+    /**************************************************************************/
+    /*!
+        @brief Return the measured number of snapshots per second of one
+               device, all devices are updated at this rate at the same time
+        @return Snapshot rate in Hz
+    */
+    /**************************************************************************/
+    double getSnapshotRate();
+
+private:
+    /**************************************************************************/
+    /*!
+        @brief Switch the AMUX of all devices to the value of the current
+               phase and discard the samples converted before
+        @return Error (True) if an error accrued during the SPI communication
+    */
+    /**************************************************************************/
+    bool switchAnalogOutputs();
+
+    LT8722 *_devices[LT8722_TELEMETRY_MAX_DEVICES];
+    uint8_t _count;
+    int8_t _channelToDevice[16];
+
+    uint32_t _settleSamples;
+    uint32_t _dwellSamples;
+    uint8_t _phase;
+    uint8_t _pending;
+    uint32_t _samples[LT8722_TELEMETRY_MAX_DEVICES];
+    uint32_t _sum[LT8722_TELEMETRY_MAX_DEVICES];
+    double _average[LT8722_TELEMETRY_MAX_DEVICES][LT8722_TELEMETRY_PHASES];
+
+    LT8722Snapshot _snapshots[LT8722_TELEMETRY_MAX_DEVICES];
+    uint32_t _sequence;
+    uint32_t _cycleStart;
+    uint32_t _cycleTime;
+
+    adc_continuous_handle_t _adc;
+    adc_cali_handle_t _cali;
+};
+
+#endif
+
+#endif
@@ -0,0 +1,37 @@
+/*
+ * File Name: test.h
+ * Description: Minimal check macro for the host tests of the parts of the
+ *              library that do not depend on the Arduino core.
+ *
+ * Notes: This code was written as part of my master's thesis at the
+ *        Institute for Microsensors, -actuators and -systems (IMSAS)
+ *        at the University of Bremen.
+ */
+
+#ifndef LT8722_TEST_H
+#define LT8722_TEST_H
+
+#include <stdio.h>
+
+static int testFailures = 0;
+
+#define CHECK(condition) do { \
+    if (!(condition)) { \
+        printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+        testFailures++; \
+    } \
+} while (0)
+
+/**************************************************************************/
+/*!
+    @brief Print the result of a test
+    @param name Name of the test
+    @return Exit code (0 if all checks passed)
+*/
+/**************************************************************************/
+static inline int report(const char *name) {
+    printf("%s: %s\n", name, testFailures == 0 ? "PASS" : "FAIL");
+    return testFailures == 0 ? 0 : 1;
+}
+
+#endif
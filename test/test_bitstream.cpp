@@ -0,0 +1,90 @@
+/*
+ * File Name: test_bitstream.cpp
+ * Description: Host test of LT8722Bitstream: frames on several chip select
+ *              lanes are encoded and decoded again without timing
+ *              violations, a setpoint frame carries the register value and
+ *              a valid CRC and broken streams are reported as violations.
+ *
+ * Notes: This code was written as part of my master's thesis at the
+ *        Institute for Microsensors, -actuators and -systems (IMSAS)
+ *        at the University of Bremen.
+ */
+
+#include "LT8722Bitstream.h"
+#include "CRC8.h"
+#include "test.h"
+
+int main() {
+    LT8722BitstreamTiming timing = {2, 1, 4};
+    LT8722Bitstream encoder(timing);
+    LT8722BitstreamFrame frames[8];
+    uint8_t stream[2048];
+    uint32_t violations = 0;
+    uint32_t length = 0;
+
+    const uint8_t status[] = {0xF0, 0x00, 0x00, 0x00};
+    const uint8_t read[] = {0xF4, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+
+    CHECK(encoder.getFrameSamples(8) == 2 + 16 * 8 + 1 + 4);
+
+    //frames of different lengths on different lanes, separated by idle samples
+    length += LT8722Bitstream::encodeIdle(stream, 3);
+    length += encoder.encodeFrame(0, status, 4, stream + length, sizeof(stream) - length);
+    length += encoder.encodeSetpoint(3, 0x00123456, stream + length, sizeof(stream) - length);
+    length += LT8722Bitstream::encodeIdle(stream + length, 10);
+    length += encoder.encodeFrame(5, read, 8, stream + length, sizeof(stream) - length);
+    CHECK(length == 3 + encoder.getFrameSamples(4) + 2 * encoder.getFrameSamples(8) + 10);
+
+    CHECK(encoder.decode(stream, length, frames, 8, &violations) == 3);
+    CHECK(violations == 0);
+
+    CHECK(frames[0].lane == 0);
+    CHECK(frames[0].length == 4);
+    CHECK(frames[0].start == 3);
+    for (uint8_t i = 0; i < 4; i++) {
+        CHECK(frames[0].data[i] == status[i]);
+    }
+
+    //the setpoint frame is a write of SPIS_DAC with a valid CRC
+    CHECK(frames[1].lane == 3);
+    CHECK(frames[1].length == 8);
+    CHECK(frames[1].data[0] == 0xF2);
+    CHECK(frames[1].data[1] == (0x04 << 1));
+    CHECK(frames[1].data[2] == 0x00 && frames[1].data[3] == 0x12);
+    CHECK(frames[1].data[4] == 0x34 && frames[1].data[5] == 0x56);
+    CHECK(frames[1].data[6] == getCRC6(frames[1].data, frames[1].data + 2));
+
+    CHECK(frames[2].lane == 5);
+    for (uint8_t i = 0; i < 8; i++) {
+        CHECK(frames[2].data[i] == read[i]);
+    }
+
+    //invalid lanes and too small outputs are not encoded
+    CHECK(encoder.encodeFrame(LT8722_BITSTREAM_MAX_LANES, status, 4, stream, sizeof(stream)) == 0);
+    CHECK(encoder.encodeFrame(0, status, 4, stream, encoder.getFrameSamples(4) - 1) == 0);
+
+    //two chip selects low at the same time
+    length = encoder.encodeFrame(1, status, 4, stream, sizeof(stream));
+    stream[5] &= ~(1 << (2 + LT8722_BITSTREAM_CS_SHIFT));
+    encoder.decode(stream, length, frames, 8, &violations);
+    CHECK(violations > 0);
+
+    //MOSI changes while SCK is high
+    length = encoder.encodeFrame(1, status, 4, stream, sizeof(stream));
+    stream[timing.setup + 1] ^= LT8722_BITSTREAM_MOSI;
+    encoder.decode(stream, length, frames, 8, &violations);
+    CHECK(violations > 0);
+
+    //the gap to the next frame is shorter than configured
+    length = encoder.encodeFrame(1, status, 4, stream, sizeof(stream));
+    length += encoder.encodeFrame(2, status, 4, stream + length - 2, sizeof(stream)) - 2;
+    encoder.decode(stream, length, frames, 8, &violations);
+    CHECK(violations > 0);
+
+    //a frame that is cut off inside a byte
+    length = encoder.encodeFrame(1, status, 4, stream, sizeof(stream));
+    CHECK(encoder.decode(stream, timing.setup + 20, frames, 8, &violations) == 0);
+    CHECK(violations > 0);
+
+    return report("test_bitstream");
+}
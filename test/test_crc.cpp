@@ -0,0 +1,46 @@
+/*
+ * File Name: test_crc.cpp
+ * Description: Host test of CRC8: the four implementations selectable with
+ *              LT8722_CRC produce identical results, so CRC_Benchmark.cpp
+ *              compares equal functions.
+ *
+ * Notes: This code was written as part of my master's thesis at the
+ *        Institute for Microsensors, -actuators and -systems (IMSAS)
+ *        at the University of Bremen.
+ */
+
+#include "CRC8.h"
+#include "test.h"
+
+int main() {
+    uint8_t frame[6] = {0xF2, 0x04 << 1, 0x00, 0x00, 0x00, 0x00};
+    uint32_t mismatches = 0;
+
+    //every value of the first two bytes with changing data bytes
+    for (uint32_t i = 0; i < 0x10000; i++) {
+        frame[0] = i >> 8;
+        frame[1] = i;
+        frame[2] = i * 0x9E37 >> 8;
+        frame[5] = i * 0x9E37;
+
+        uint8_t crc = getCRC6(frame, frame + 2);
+        mismatches += (getCRC6Table(frame, frame + 2) != crc);
+        mismatches += (getCRC6TableRAM(frame, frame + 2) != crc);
+        mismatches += (getCRC6Nibble(frame, frame + 2) != crc);
+        mismatches += (getCRC6Bitwise(frame, frame + 2) != crc);
+        mismatches += (CRC_8_TABLE[frame[0]] != CRC_8_TABLE_RAM[frame[0]]);
+    }
+    CHECK(mismatches == 0);
+
+    //the CRC of a frame extended by its own CRC is zero
+    frame[0] = 0x12;
+    frame[1] = 0x34;
+    uint8_t message[3] = {frame[0], frame[1], getCRC2(frame)};
+    uint8_t crc = 0x00;
+    for (uint8_t i = 0; i < 3; i++) {
+        crc = CRC_8_TABLE[crc ^ message[i]];
+    }
+    CHECK(crc == 0x00);
+
+    return report("test_crc");
+}
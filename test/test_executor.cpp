@@ -0,0 +1,107 @@
+/*
+ * File Name: test_executor.cpp
+ * Description: Host test of LT8722Executor: every channel is computed once
+ *              per cycle and issued in channel order after its compute
+ *              function, no cycle runs after a restart of the workers and
+ *              a cycle without workers is rejected.
+ *
+ * Notes: This code was written as part of my master's thesis at the
+ *        Institute for Microsensors, -actuators and -systems (IMSAS)
+ *        at the University of Bremen.
+ */
+
+#include "LT8722Executor.h"
+#include "test.h"
+
+#include <chrono>
+
+#define CHANNELS 32
+#define CYCLES   200
+
+struct Channel {
+    std::atomic<uint32_t> computed;
+    uint32_t issued;
+};
+
+Channel channels[CHANNELS];
+uint8_t lastIssued;
+bool ordered;
+
+void compute(uint8_t channel, void *context) {
+    Channel *state = (Channel *)context;
+    volatile uint32_t work = 0;
+
+    //uneven work, so that the workers have to steal
+    for (uint32_t i = 0; i < (channel % 4) * 1000u; i++) {
+        work = work + i;
+    }
+    state->computed++;
+}
+
+void issue(uint8_t channel, void *context) {
+    Channel *state = (Channel *)context;
+
+    //the issue stage runs in channel order and after the compute function
+    ordered &= (channel == (lastIssued + 1) % CHANNELS);
+    ordered &= (state->computed.load() == state->issued + 1);
+    lastIssued = channel;
+    state->issued++;
+}
+
+int main() {
+    LT8722Executor executor;
+
+    for (uint8_t i = 0; i < CHANNELS; i++) {
+        channels[i].computed = 0;
+        channels[i].issued = 0;
+        CHECK(!executor.addChannel(compute, issue, &channels[i]));
+    }
+
+    //a cycle without workers must not divide by zero
+    CHECK(executor.runCycle());
+    CHECK(executor.begin(0, 1000));
+    CHECK(executor.begin(LT8722_EXECUTOR_MAX_WORKERS + 1, 1000));
+
+    CHECK(!executor.begin(4, 1000000));
+    CHECK(executor.begin(4, 1000000));                  //already running
+    lastIssued = CHANNELS - 1;
+    ordered = true;
+    for (uint16_t i = 0; i < CYCLES; i++) {
+        executor.runCycle();
+    }
+    CHECK(ordered);
+    for (uint8_t i = 0; i < CHANNELS; i++) {
+        CHECK(channels[i].computed.load() == CYCLES);
+        CHECK(channels[i].issued == CYCLES);
+    }
+    for (uint8_t i = 0; i < 4; i++) {
+        CHECK(executor.getUtilization(i) >= 0.0 && executor.getUtilization(i) <= 1.0);
+    }
+    CHECK(executor.getUtilization(4) == 0.0);
+    executor.end();
+
+    //restarted workers must wait for the next cycle instead of running a stale one
+    CHECK(!executor.begin(2, 1000000));
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    for (uint8_t i = 0; i < CHANNELS; i++) {
+        CHECK(channels[i].computed.load() == CYCLES);
+    }
+    executor.runCycle();
+    CHECK(ordered);
+    for (uint8_t i = 0; i < CHANNELS; i++) {
+        CHECK(channels[i].computed.load() == CYCLES + 1);
+    }
+    executor.end();
+    executor.end();                                     //not started, nothing to join
+
+    //a started executor may be destroyed without end()
+    {
+        LT8722Executor scoped;
+        CHECK(!scoped.addChannel(compute, issue, &channels[0]));
+        CHECK(!scoped.begin(2, 1000000));
+        scoped.runCycle();
+    }
+    CHECK(channels[0].computed.load() == CYCLES + 2);
+
+    return report("test_executor");
+}
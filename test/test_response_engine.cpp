@@ -0,0 +1,70 @@
+/*
+ * File Name: test_response_engine.cpp
+ * Description: Host test of LT8722ResponseEngine against a discrete first
+ *              order plant with an offset on the response. The measured
+ *              gain and phase have to match the analytic frequency response
+ *              of the plant.
+ *
+ * Notes: This code was written as part of my master's thesis at the
+ *        Institute for Microsensors, -actuators and -systems (IMSAS)
+ *        at the University of Bremen.
+ */
+
+#include "LT8722ResponseEngine.h"
+#include "test.h"
+
+#include <math.h>
+#include <complex>
+
+int main() {
+    const uint8_t count = 8;
+    const double sampleRate = 100;
+    const double tau = 0.5;                         //time constant of the plant in seconds
+    const double k = 3;                             //static gain of the plant
+    double frequencies[count];
+    double gain[count];
+    double phase[count];
+
+    LT8722ResponseEngine::logSweep(frequencies, count, 0.05, 20);
+    CHECK(fabs(frequencies[0] - 0.05) < 1e-9);
+    CHECK(fabs(frequencies[count - 1] - 20) < 1e-9);
+
+    //without begin() the engine is complete and returns a defined offset
+    LT8722ResponseEngine empty;
+    CHECK(empty.isComplete());
+    CHECK(empty.next() == 0.0);
+
+    //y[n] = a * y[n-1] + (1 - a) * k * u[n], the response carries an offset of 5
+    LT8722ResponseEngine engine;
+    engine.begin(frequencies, gain, phase, count, 1.0, 0.5, sampleRate, 3, 5);
+
+    double a = exp(-1 / (sampleRate * tau));
+    double y = 1.0;
+    uint32_t samples = 0;
+    while (!engine.isComplete() && samples < 1000000) {
+        double u = engine.next();
+        y = a * y + (1 - a) * k * u;
+        engine.update(y + 5);
+        samples++;
+    }
+    CHECK(engine.isComplete());
+
+    for (uint8_t i = 0; i < count; i++) {
+        std::complex<double> z = std::exp(std::complex<double>(0, 2 * M_PI * frequencies[i] / sampleRate));
+        std::complex<double> h = k * (1 - a) * z / (z - a);
+
+        double gainError = fabs(gain[i] - std::abs(h)) / std::abs(h);
+        double phaseError = fabs(phase[i] - std::arg(h) * 180 / M_PI);
+        if (gainError > 0.05 || phaseError > 3) {
+            printf("f=%.3fHz gain %.4f (model %.4f) phase %.2f (model %.2f)\n", frequencies[i], gain[i],
+                   std::abs(h), phase[i], std::arg(h) * 180 / M_PI);
+        }
+        CHECK(gainError <= 0.05);
+        CHECK(phaseError <= 3);
+    }
+
+    //after the sweep the offset is returned
+    CHECK(engine.next() == 1.0);
+
+    return report("test_response_engine");
+}
@@ -0,0 +1,80 @@
+/*
+ * File Name: test_sample_ring.cpp
+ * Description: Host test of LT8722SampleRing: pre- and post-trigger samples,
+ *              wrap-around of the ring, edge triggers and a ring without a
+ *              buffer.
+ *
+ * Notes: This code was written as part of my master's thesis at the
+ *        Institute for Microsensors, -actuators and -systems (IMSAS)
+ *        at the University of Bremen.
+ */
+
+#include "LT8722SampleRing.h"
+#include "test.h"
+
+int main() {
+    uint16_t buffer[8];
+    uint16_t output[16];
+    uint16_t samples[32];
+    LT8722SampleRing ring;
+
+    for (uint16_t i = 0; i < 32; i++) {
+        samples[i] = i * 100;
+    }
+
+    //a ring without a buffer must neither crash nor report samples
+    CHECK(ring.begin(NULL, 8, 2));
+    CHECK(ring.begin(buffer, 0, 2));
+    CHECK(ring.arm());
+    ring.push(samples, 4);
+    CHECK(ring.read(output, 16) == 0);
+    CHECK(ring.getCaptured() == 0);
+
+    //manual trigger after the ring wrapped: 3 samples before, 5 after the trigger
+    CHECK(!ring.begin(buffer, 8, 3));
+    CHECK(!ring.arm());
+    ring.push(samples, 13);
+    ring.trigger();
+    ring.push(samples + 13, 10);
+    CHECK(ring.getState() == CAPTURE_STATE::COMPLETE);
+    CHECK(ring.getCaptured() == 8);
+    CHECK(ring.getPretrigger() == 3);
+    CHECK(ring.read(output, 16) == 8);
+    for (uint16_t i = 0; i < 8; i++) {
+        CHECK(output[i] == samples[10 + i]);
+    }
+
+    //read is limited to the requested count
+    CHECK(ring.read(output, 5) == 5);
+    CHECK(output[4] == samples[14]);
+
+    //rising edge with fewer samples before the trigger than requested
+    CHECK(!ring.begin(buffer, 8, 6));
+    ring.setTrigger(CAPTURE_TRIGGER::RISING_EDGE, 250);
+    CHECK(!ring.arm());
+    ring.push(samples, 32);
+    CHECK(ring.getState() == CAPTURE_STATE::COMPLETE);
+    CHECK(ring.getPretrigger() == 3);
+    CHECK(ring.read(output, 16) == 8);
+    CHECK(output[3] == 300);
+    CHECK(output[7] == 700);
+
+    //pre-trigger larger than the ring is limited
+    CHECK(!ring.begin(buffer, 4, 10));
+    ring.setTrigger(CAPTURE_TRIGGER::MANUAL);
+    CHECK(!ring.arm());
+    ring.push(samples, 6);
+    ring.trigger();
+    ring.push(samples + 6, 1);
+    CHECK(ring.getState() == CAPTURE_STATE::COMPLETE);
+    CHECK(ring.getPretrigger() == 3);
+
+    //stop keeps a complete capture, but disarms an incomplete one
+    ring.stop();
+    CHECK(ring.getState() == CAPTURE_STATE::COMPLETE);
+    CHECK(!ring.arm());
+    ring.stop();
+    CHECK(ring.getState() == CAPTURE_STATE::IDLE);
+
+    return report("test_sample_ring");
+}